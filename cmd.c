@@ -0,0 +1,178 @@
+/*
+ * File:   cmd.c
+ * Author: group 6
+ *
+ * Table-driven command parser: $NAME,arg,...*hh frames, where the NMEA-style
+ * checksum hh (XOR of the characters between '$' and '*', in hex) is optional.
+ * The name is hashed while it is received, so each frame costs O(length).
+ */
+
+#include "cmd.h"
+
+#define CMD_WAIT 0     // waiting for '$'
+#define CMD_NAME 1     // receiving the name
+#define CMD_ARGS 2     // receiving the arguments
+#define CMD_CHECK 3    // '*' received, optional checksum
+
+// one step of the hash of the names
+#define CMD_HASH(h, c) ((unsigned char) (((h) << 1) ^ (unsigned char) (c)))
+
+unsigned char cmd_hash_name(const char* name){
+    unsigned char h = 0;
+
+    while (*name) h = CMD_HASH(h, *name++);
+    return h;
+}
+
+// builds the hash index of the table (open addressing, linear probing)
+void cmd_init(CmdParser* p, const CmdEntry* table, int count, void (*error)(int code)){
+    p->table = table;
+    p->count = count;
+    p->error = error;
+    p->state = CMD_WAIT;
+
+    for (int i = 0; i < CMD_HASH_SIZE; i++) p->index[i] = -1;
+    for (int i = 0; i < count; i++) {
+        unsigned int h = cmd_hash_name(table[i].name) & (CMD_HASH_SIZE - 1);
+
+        while (p->index[h] >= 0) h = (h + 1) & (CMD_HASH_SIZE - 1);
+        p->index[h] = i;
+    }
+}
+
+const CmdEntry* cmd_lookup(CmdParser* p){
+    unsigned int h = p->hash & (CMD_HASH_SIZE - 1);
+    const char* name = p->buf;
+
+    while (p->index[h] >= 0) {
+        const CmdEntry* e = &p->table[(int) p->index[h]];
+        const char* a = e->name;
+        const char* b = name;
+
+        while (*a && *a == *b) {
+            a++;
+            b++;
+        }
+        if (*a == 0 && *b == 0) return e;
+        h = (h + 1) & (CMD_HASH_SIZE - 1);
+    }
+    return 0;
+}
+
+// Returns 1 and the value if the token is a non-empty decimal number
+int cmd_parse_number(const char* s, long* value){
+    long v = 0;
+
+    if (*s == 0) return 0;
+    while (*s) {
+        if (*s < '0' || *s > '9' || v > 99999999L) return 0;
+        v = v * 10 + (*s++ - '0');
+    }
+    *value = v;
+    return 1;
+}
+
+int cmd_hex(char c){
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// the frame is complete: split the arguments, check them against the schema, run the command
+void cmd_dispatch(CmdParser* p){
+    CmdArg argv[CMD_MAX_ARGS];
+    const CmdEntry* e;
+    int argc = 0;
+    const char* schema;
+
+    p->state = CMD_WAIT;
+    if (p->check_len == 1 || (p->check_len == 2 && p->check != p->sum)) { // truncated or wrong
+        p->error(CMD_ERR_CHECKSUM);
+        return;
+    }
+
+    p->buf[p->len] = 0;
+    e = cmd_lookup(p);
+    if (e == 0) return; // unknown command, ignored
+
+    // the commas have been replaced by 0 while receiving
+    for (unsigned int i = p->name_len; i < p->len && argc < CMD_MAX_ARGS; i++) {
+        if (p->buf[i] == 0) argv[argc++].str = &p->buf[i + 1];
+    }
+
+    schema = e->args;
+    for (int i = 0; i < argc; i++, schema++) {
+        if (*schema == 0) break; // too many arguments
+        if (*schema == 'u' && !cmd_parse_number(argv[i].str, &argv[i].num)) break;
+        if (*schema == 's') argv[i].num = 0;
+    }
+    if (schema - e->args != argc || *schema != 0) {
+        if (e->error) p->error(e->error);
+        return;
+    }
+    e->handler(argc, argv);
+}
+
+// parses a block of received characters
+void cmd_feed(CmdParser* p, const char* data, unsigned int n){
+    for (unsigned int i = 0; i < n; i++) {
+        char c = data[i];
+
+        if (p->state == CMD_CHECK) {
+            int d = cmd_hex(c);
+
+            if (d >= 0 && p->check_len < 2) {
+                p->check = (p->check << 4) | d;
+                p->check_len++;
+                if (p->check_len == 2) cmd_dispatch(p);
+                continue;
+            }
+            cmd_dispatch(p); // no checksum, c belongs to what follows
+        }
+
+        if (c == '$') { // a '$' always starts a new frame
+            p->state = CMD_NAME;
+            p->len = 0;
+            p->sum = 0;
+            p->hash = 0;
+            p->name_len = 0;
+            continue;
+        }
+
+        switch (p->state) {
+            case CMD_NAME:
+            case CMD_ARGS:
+                if (c == '*') {
+                    if (p->state == CMD_NAME) p->name_len = p->len;
+                    p->state = CMD_CHECK;
+                    p->check = 0;
+                    p->check_len = 0;
+                    p->ticks = 0;
+                    break;
+                }
+                if (p->len == CMD_MAX_LEN) { // too long, drop the frame
+                    p->state = CMD_WAIT;
+                    break;
+                }
+                p->sum ^= c;
+                if (c == ',') {
+                    if (p->state == CMD_NAME) p->name_len = p->len;
+                    p->state = CMD_ARGS;
+                    c = 0;
+                } else if (p->state == CMD_NAME) {
+                    p->hash = CMD_HASH(p->hash, c);
+                }
+                p->buf[p->len++] = c;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// called once per tick: a frame without checksum is run after CMD_TIMEOUT ticks
+void cmd_tick(CmdParser* p){
+    if (p->state != CMD_CHECK) return;
+    if (++p->ticks >= CMD_TIMEOUT) cmd_dispatch(p);
+}
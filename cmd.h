@@ -0,0 +1,88 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef CMD_H
+#define	CMD_H
+
+#define CMD_MAX_LEN 32   // characters between '$' and '*'
+#define CMD_MAX_ARGS 4
+#define CMD_HASH_SIZE 16 // buckets of the command lookup, power of two, > number of commands
+#define CMD_TIMEOUT 2    // ticks to wait for the optional checksum after '*'
+
+// error codes passed to the error handler (the commands use their own codes)
+#define CMD_ERR_CHECKSUM 6
+
+// argument of a command: the token and, for numeric arguments, its value
+typedef struct {
+    const char* str;
+    long num;
+} CmdArg;
+
+// command table entry. args is the schema, one character per argument:
+// 'u' unsigned number, 's' word. A frame that does not match it is
+// reported with the error code of the command (0 = ignored)
+typedef struct {
+    const char* name;
+    const char* args;
+    void (*handler)(int argc, const CmdArg* argv);
+    int error;
+} CmdEntry;
+
+typedef struct {
+    const CmdEntry* table;
+    int count;
+    void (*error)(int code);
+    signed char index[CMD_HASH_SIZE]; // hash -> table entry, -1 if empty
+    char buf[CMD_MAX_LEN + 1];
+    unsigned int len;
+    unsigned char state;
+    unsigned char sum;   // XOR of the characters between '$' and '*'
+    unsigned char hash;  // hash of the command name, computed while receiving
+    unsigned char name_len;
+    unsigned char check; // checksum received after '*'
+    unsigned char check_len;
+    unsigned char ticks; // ticks waiting for the checksum
+} CmdParser;
+
+void cmd_init(CmdParser* p, const CmdEntry* table, int count, void (*error)(int code));
+void cmd_feed(CmdParser* p, const char* data, unsigned int n);
+void cmd_tick(CmdParser* p);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* CMD_H */
+
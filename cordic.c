@@ -0,0 +1,124 @@
+/*
+ * File:   cordic.c
+ * Author: group 6
+ *
+ * Fixed-point CORDIC used for the heading, replacing the double precision atan2.
+ */
+
+#include "cordic.h"
+
+// atan(2^-i) in binary angle units (2^20 per turn)
+const long cordic_atan_table[CORDIC_ITERATIONS] = {
+    131072, 77376, 40884, 20753, 10417, 5213, 2607, 1304,
+    652, 326, 163, 81, 41, 20, 10, 5
+};
+
+// binary angle of (x, y) in CORDIC vectoring mode
+unsigned long cordic_vector(long y, long x){
+    unsigned long angle = 0;
+    long ax, ay, m, xn;
+
+    // rotate into the right half-plane, the iterations cover +-99 degrees
+    if (x < 0) {
+        x = -x;
+        y = -y;
+        angle = CORDIC_TURN / 2;
+    }
+
+    // normalise the magnitude to [2^21, 2^22) so that the shifts keep their precision
+    // and the CORDIC gain (1.65 * sqrt(2)) cannot overflow
+    ax = x;
+    ay = (y < 0) ? -y : y;
+    m = (ax > ay) ? ax : ay;
+    while (m >= (1L << 22)) {
+        x >>= 1;
+        y >>= 1;
+        m >>= 1;
+    }
+    while (m < (1L << 21)) {
+        x <<= 1;
+        y <<= 1;
+        m <<= 1;
+    }
+
+    // drive y to zero, accumulating the rotation
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        xn = x;
+        if (y > 0) {
+            x += y >> i;
+            y -= xn >> i;
+            angle += cordic_atan_table[i];
+        } else {
+            x -= y >> i;
+            y += xn >> i;
+            angle -= cordic_atan_table[i];
+        }
+    }
+
+    return angle & CORDIC_TURN_MASK;
+}
+
+// 1/gain of the CORDIC iterations in Q15 (0.607253)
+#define CORDIC_INV_GAIN 19898L
+
+void cordic_rotate(long* x, long* y, unsigned long angle){
+    long z, xn;
+    long xr = *x;
+    long yr = *y;
+
+    // bring the angle into +-180 degrees, then into +-90 degrees by a half turn
+    z = (long) (angle & CORDIC_TURN_MASK);
+    if (z >= CORDIC_TURN / 2) z -= CORDIC_TURN;
+    if (z > CORDIC_TURN / 4 || z < -CORDIC_TURN / 4) {
+        xr = -xr;
+        yr = -yr;
+        z += (z > 0) ? -CORDIC_TURN / 2 : CORDIC_TURN / 2;
+    }
+
+    // drive the residual angle to zero
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        xn = xr;
+        if (z > 0) {
+            xr -= yr >> i;
+            yr += xn >> i;
+            z -= cordic_atan_table[i];
+        } else {
+            xr += yr >> i;
+            yr -= xn >> i;
+            z += cordic_atan_table[i];
+        }
+    }
+
+    *x = (long) (((long long) xr * CORDIC_INV_GAIN) >> 15);
+    *y = (long) (((long long) yr * CORDIC_INV_GAIN) >> 15);
+}
+
+int cordic_heading(long mx, long my, long mz, long ax, long ay, long az){
+    unsigned long roll, pitch;
+    long gz = az, gy = ay;
+
+    // roll: rotate around x so that gravity has no y component
+    roll = (ay == 0 && az == 0) ? 0 : cordic_vector(ay, az);
+    cordic_rotate(&mz, &my, -roll);
+    cordic_rotate(&gz, &gy, -roll);
+
+    // pitch: rotate around y so that gravity lies on z, only the x component is needed
+    pitch = (ax == 0 && gz == 0) ? 0 : cordic_vector(-ax, gz);
+    cordic_rotate(&mz, &mx, pitch);
+
+    return cordic_atan2(my, mx);
+}
+
+int cordic_atan2(long y, long x){
+    unsigned long angle;
+    unsigned int decideg;
+
+    if (x == 0 && y == 0) return 0;
+
+    angle = cordic_vector(y, x);
+
+    // 2^20 units -> 3600 tenths of degree, rounded
+    decideg = (unsigned int) ((angle * 3600 + CORDIC_TURN / 2) >> 20);
+    if (decideg >= 3600) decideg -= 3600;
+    return decideg;
+}
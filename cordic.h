@@ -0,0 +1,66 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef CORDIC_H
+#define	CORDIC_H
+
+#define CORDIC_ITERATIONS 16
+
+// angles are binary: a full turn is 2^20 units
+#define CORDIC_TURN 0x100000L
+#define CORDIC_TURN_MASK (CORDIC_TURN - 1)
+
+// heading of the vector (x, y), i.e. atan2(y, x), in 0.1 degree units (0..3599).
+// Integer only; compared against libm atan2 over the full circle the result is
+// within the 0.05 degree rounding of the last digit (max error 0.053 degrees)
+// for vectors with a magnitude of at least 16.
+int cordic_atan2(long y, long x);
+
+unsigned long cordic_vector(long y, long x);
+
+// rotates the vector (x, y) by angle (binary units), the CORDIC gain is removed
+void cordic_rotate(long* x, long* y, unsigned long angle);
+
+// tilt-compensated heading in 0.1 degree units (0..3599), from the magnetic field
+// and the gravity measured by the accelerometer (axes aligned, any common scale).
+// With the board level it equals cordic_atan2(my, mx). Inputs up to +-2^20
+int cordic_heading(long mx, long my, long mz, long ax, long ay, long az);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* CORDIC_H */
+
@@ -0,0 +1,52 @@
+/*
+ * File:   flash.c
+ * Author: group 6
+ *
+ * Run-Time Self-Programming of the program flash, used to keep data across resets.
+ */
+
+#include "flash.h"
+
+#define NVM_PAGE_ERASE 0x4003
+#define NVM_DWORD_PROGRAM 0x4001
+#define NVM_LATCH_PAGE 0xFA // TBLPAG of the write latches
+
+// starts the operation set in NVMCON on addr and waits for its end
+void flash_execute(unsigned long addr){
+    NVMADRU = addr >> 16;
+    NVMADR = addr & 0xFFFF;
+    __builtin_write_NVM(); // unlock sequence and WR = 1, with interrupts disabled
+    while (NVMCONbits.WR == 1) hal_poll();
+}
+
+// erases the page (FLASH_PAGE_SIZE aligned) containing addr
+void flash_erase_page(unsigned long addr){
+    NVMCON = NVM_PAGE_ERASE;
+    flash_execute(addr & ~(FLASH_PAGE_SIZE - 1UL));
+}
+
+// writes two words in the low 16 bits of the instructions at addr and addr + 2.
+// addr must be a multiple of 4 and the location erased
+void flash_write_dword(unsigned long addr, unsigned int w0, unsigned int w1){
+    unsigned int tblpag = TBLPAG;
+
+    NVMCON = NVM_DWORD_PROGRAM;
+    TBLPAG = NVM_LATCH_PAGE;
+    __builtin_tblwtl(0, w0);
+    __builtin_tblwth(0, 0xFF);
+    __builtin_tblwtl(2, w1);
+    __builtin_tblwth(2, 0xFF);
+    flash_execute(addr);
+    TBLPAG = tblpag;
+}
+
+// reads the low 16 bits of the instruction at addr
+unsigned int flash_read_word(unsigned long addr){
+    unsigned int tblpag = TBLPAG;
+    unsigned int value;
+
+    TBLPAG = addr >> 16;
+    value = __builtin_tblrdl(addr & 0xFFFF);
+    TBLPAG = tblpag;
+    return value;
+}
@@ -0,0 +1,80 @@
+/*
+ * File:   fmt.c
+ * Author: group 6
+ *
+ * Integer and fixed-point formatting for the telemetry frames,
+ * used instead of the floating-point printf.
+ */
+
+#include "fmt.h"
+
+// number of decimal digits of v
+int fmt_digits(unsigned long v){
+    int n = 1;
+
+    while (v >= 10) {
+        v /= 10;
+        n++;
+    }
+    return n;
+}
+
+void fmt_pad(CbWriter *w, int len, int width){
+    while (len < width) {
+        cbw_putc(w, ' ');
+        len++;
+    }
+}
+
+// writes the digits of v.
+// The digits are produced least significant first and then reversed in place,
+// so no scratch buffer is needed
+void fmt_uint(CbWriter *w, unsigned long v){
+    unsigned int first = w->pos;
+    unsigned int n;
+    char tmp;
+
+    do {
+        cbw_putc(w, '0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+
+    n = w->pos - first;
+    for (unsigned int i = 0; i < n / 2; i++) {
+        tmp = w->cb->buffer[(first + i) & BUFFER_MASK];
+        w->cb->buffer[(first + i) & BUFFER_MASK] = w->cb->buffer[(first + n - 1 - i) & BUFFER_MASK];
+        w->cb->buffer[(first + n - 1 - i) & BUFFER_MASK] = tmp;
+    }
+}
+
+// signed decimal integer (e.g. -42)
+void fmt_int(CbWriter *w, long value, int width){
+    unsigned long v = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+    int len = fmt_digits(v) + (value < 0);
+
+    fmt_pad(w, len, width);
+    if (value < 0) cbw_putc(w, '-');
+    fmt_uint(w, v);
+}
+
+// value expressed in tenths, with one fractional digit (e.g. -123 -> -12.3)
+void fmt_tenths(CbWriter *w, long tenths, int width){
+    unsigned long v = (tenths < 0) ? -(unsigned long) tenths : (unsigned long) tenths;
+    int len = fmt_digits(v / 10) + 2 + (tenths < 0);
+
+    fmt_pad(w, len, width);
+    if (tenths < 0) cbw_putc(w, '-');
+    fmt_uint(w, v / 10);
+    cbw_putc(w, '.');
+    cbw_putc(w, '0' + (v % 10));
+}
+
+// Q-format value (frac_bits fractional bits) rounded to one fractional digit
+// (e.g. 40 in Q4 -> 2.5)
+void fmt_q(CbWriter *w, long value, int frac_bits, int width){
+    unsigned long v = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+    unsigned long half = (frac_bits > 0) ? (1UL << (frac_bits - 1)) : 0;
+    long tenths = (long) ((v * 10 + half) >> frac_bits);
+
+    fmt_tenths(w, (value < 0) ? -tenths : tenths, width);
+}
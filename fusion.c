@@ -0,0 +1,65 @@
+/*
+ * File:   fusion.c
+ * Author: group 6
+ *
+ * Yaw from the gyroscope z rate, integrated every tick, corrected by the
+ * magnetometer heading with a complementary (or Kalman) filter.
+ * The z rate is taken as the yaw rate, which holds while the board is nearly level.
+ */
+
+#include "fusion.h"
+
+void fusion_init(YawFilter* f){
+    f->yaw = 0;
+    f->ready = 0;
+#ifdef FUSION_KALMAN
+    f->p = FUSION_R;
+#endif
+}
+
+// integrates the z rate (gyroscope LSB) over one tick.
+// The heading grows clockwise seen from above, the z rate counter-clockwise
+void fusion_predict(YawFilter* f, int rate_z){
+    f->yaw -= (unsigned long) (((long) rate_z * FUSION_RATE_GAIN) >> 8);
+    f->yaw &= FUSION_TURN - 1;
+#ifdef FUSION_KALMAN
+    if (f->p < FUSION_R) f->p += FUSION_Q; // bounded while the magnetometer is missing
+#endif
+}
+
+// corrects the yaw with a magnetometer heading in 0.1 degree units
+void fusion_correct(YawFilter* f, int heading){
+    unsigned long target = (((unsigned long) heading << 20) / 3600) << (FUSION_TURN_BITS - 20);
+    long err;
+
+    if (!f->ready) {
+        f->yaw = target;
+        f->ready = 1;
+        return;
+    }
+
+    // error on the shortest way around the circle
+    err = (long) ((target - f->yaw) & (FUSION_TURN - 1));
+    if (err >= (long) (FUSION_TURN / 2)) err -= FUSION_TURN;
+
+#ifdef FUSION_KALMAN
+    {
+        // gain in Q16: p / (p + r)
+        unsigned long k = f->p / ((f->p + FUSION_R) >> 16);
+
+        f->yaw += (unsigned long) (((err >> 12) * (long) k) >> 4);
+        f->p -= (f->p >> 8) * k >> 8;
+    }
+#else
+    f->yaw += (unsigned long) (err >> FUSION_GAIN_SHIFT);
+#endif
+    f->yaw &= FUSION_TURN - 1;
+}
+
+// yaw in 0.1 degree units (0..3599)
+int fusion_yaw(const YawFilter* f){
+    unsigned int decideg = (unsigned int) (((f->yaw >> 8) * 3600 + (1UL << (FUSION_TURN_BITS - 9))) >> (FUSION_TURN_BITS - 8));
+
+    if (decideg >= 3600) decideg -= 3600;
+    return decideg;
+}
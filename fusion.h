@@ -0,0 +1,77 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef FUSION_H
+#define	FUSION_H
+
+// yaw is kept in binary units, a full turn is 2^28
+#define FUSION_TURN_BITS 28
+#define FUSION_TURN (1UL << FUSION_TURN_BITS)
+
+// gyroscope scale: +-250 deg/s range, 131.2 LSB per deg/s, integrated every 10ms.
+// One LSB over a tick is 0.01 / 131.2 deg = 0.2220 * 2^20 / 360 units of a 2^20 turn:
+// FUSION_RATE_GAIN is that step in 2^28 units, Q8 (0.2220 * 2^8 * 2^8)
+#define FUSION_RATE_GAIN 14549L
+
+// complementary filter: each magnetometer heading pulls the yaw by 1/2^FUSION_GAIN_SHIFT
+// of the error (time constant of about 0.3s with 25 headings per second)
+#define FUSION_GAIN_SHIFT 3
+
+// define FUSION_KALMAN to replace the fixed gain with a one-state Kalman filter.
+// Variances in Q16 (0.1 degree)^2
+#ifdef FUSION_KALMAN
+#define FUSION_Q 655L      // gyro integration noise per tick, 0.01
+#define FUSION_R 6553600L  // magnetometer heading noise, 100 (1 degree rms)
+#endif
+
+typedef struct {
+    unsigned long yaw; // 2^28 units per turn
+    int ready;         // 0 until the first magnetometer heading
+#ifdef FUSION_KALMAN
+    unsigned long p;   // variance of the yaw, Q16 (0.1 degree)^2
+#endif
+} YawFilter;
+
+void fusion_init(YawFilter* f);
+void fusion_predict(YawFilter* f, int rate_z);
+void fusion_correct(YawFilter* f, int heading);
+int fusion_yaw(const YawFilter* f);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* FUSION_H */
+
@@ -0,0 +1,85 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef HAL_H
+#define	HAL_H
+
+#include <xc.h> // include processor files, the simulated ones in the host build (sim/xc.h)
+
+// thin hardware abstraction layer: the registers whose accesses have side effects
+// (data registers, DMA start, chip-selects, busy waits) go through these macros,
+// the configuration registers are written directly. On the dsPIC every macro is
+// a plain register access; the host build routes them to the simulator (sim/sim.c)
+#ifndef HAL_HOST
+
+// SPI1 data register
+#define hal_spi_put(b) (SPI1BUF = (b))
+#define hal_spi_get() (SPI1BUF)
+
+// DMA: address of a RAM buffer for DMAxSTAL, start of the transfer of DMA0
+#define hal_dma_addr(p) ((unsigned int) (p))
+#define hal_dma_force() (DMA0REQbits.FORCE = 1)
+
+// UART1 data registers
+#define hal_uart_put(c) (U1TXREG = (c))
+#define hal_uart_get() (U1RXREG)
+
+// GPIO: sets or clears the bits of a LAT register
+#define hal_gpio_set(lat, mask) (*(lat) |= (mask))
+#define hal_gpio_clear(lat, mask) (*(lat) &= ~(mask))
+
+// body of the busy-wait loops: nothing to do, the hardware runs by itself
+#define hal_poll()
+
+#else
+
+#define hal_spi_put(b) sim_spi_put(b)
+#define hal_spi_get() sim_spi_get()
+#define hal_dma_addr(p) sim_dma_addr(p)
+#define hal_dma_force() sim_dma_force()
+#define hal_uart_put(c) sim_uart_put(c)
+#define hal_uart_get() sim_uart_get()
+#define hal_gpio_set(lat, mask) sim_gpio_write((lat), *(lat) | (mask))
+#define hal_gpio_clear(lat, mask) sim_gpio_write((lat), *(lat) & ~(mask))
+#define hal_poll() sim_wait() // let the simulated time run to the next event
+
+#endif
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* HAL_H */
+
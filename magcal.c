@@ -0,0 +1,131 @@
+/*
+ * File:   magcal.c
+ * Author: group 6
+ *
+ * Hard/soft-iron calibration of the magnetometer from the min/max of the
+ * samples collected while the board is rotated, kept in program flash.
+ */
+
+#include "magcal.h"
+#include "flash.h"
+
+#define MAGCAL_MAGIC 0xCA1B
+
+// flash page reserved for the calibration: magic, offsets, scales, checksum
+#define MAGCAL_WORDS (2 + 2 * MAGCAL_AXES)
+__prog__ const unsigned int __attribute__((space(prog), aligned(FLASH_PAGE_SIZE))) magcal_page[FLASH_PAGE_WORDS];
+
+void magcal_identity(MagCal* cal){
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        cal->offset[i] = 0;
+        cal->scale[i] = 1 << MAGCAL_SCALE_BITS;
+    }
+}
+
+// calibrates the values of all the axes in place (saturated to +-32767)
+void magcal_apply(const MagCal* cal, int* values){
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        long v = (((long) values[i] - cal->offset[i]) * cal->scale[i]) >> MAGCAL_SCALE_BITS;
+
+        if (v > 32767) v = 32767;
+        if (v < -32767) v = -32767;
+        values[i] = (int) v;
+    }
+}
+
+void magcal_start(MagCalTracker* tracker){
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        tracker->min[i] = 32767;
+        tracker->max[i] = -32767;
+    }
+    tracker->count = 0;
+}
+
+void magcal_track(MagCalTracker* tracker, const int* values){
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        if (values[i] < tracker->min[i]) tracker->min[i] = values[i];
+        if (values[i] > tracker->max[i]) tracker->max[i] = values[i];
+    }
+    tracker->count++;
+}
+
+// offsets are the centres of the ranges; the scales bring every axis
+// to the mean radius. Returns 0 (and leaves cal unchanged) if the axes have
+// not been covered enough or their ranges are too different to be a field
+int magcal_finish(const MagCalTracker* tracker, MagCal* cal){
+    long radius[MAGCAL_AXES];
+    long mean = 0, min_radius, max_radius;
+    unsigned long scale[MAGCAL_AXES];
+
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        radius[i] = ((long) tracker->max[i] - tracker->min[i]) / 2;
+        if (radius[i] < MAGCAL_MIN_SPAN / 2) return 0;
+        mean += radius[i];
+    }
+    mean /= MAGCAL_AXES;
+
+    min_radius = max_radius = radius[0];
+    for (int i = 1; i < MAGCAL_AXES; i++) {
+        if (radius[i] < min_radius) min_radius = radius[i];
+        if (radius[i] > max_radius) max_radius = radius[i];
+    }
+    if (max_radius > MAGCAL_MAX_RATIO * min_radius) return 0;
+
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        scale[i] = (unsigned long) (mean << MAGCAL_SCALE_BITS) / radius[i];
+        if (scale[i] > 0xFFFF) return 0; // does not fit the Q12 scale
+    }
+
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        cal->offset[i] = (int) (((long) tracker->max[i] + tracker->min[i]) / 2);
+        cal->scale[i] = (unsigned int) scale[i];
+    }
+    return 1;
+}
+
+// word i of the stored calibration
+unsigned int magcal_word(const MagCal* cal, int i){
+    if (i == 0) return MAGCAL_MAGIC;
+    if (i <= MAGCAL_AXES) return (unsigned int) cal->offset[i - 1];
+    return cal->scale[i - 1 - MAGCAL_AXES];
+}
+
+// reads the calibration saved in flash.
+// Returns 0 (and the identity) if there is no valid calibration
+int magcal_load(MagCal* cal){
+    unsigned long addr = __builtin_tbladdress(magcal_page);
+    unsigned int sum = 0;
+
+    if (flash_read_word(addr) != MAGCAL_MAGIC) {
+        magcal_identity(cal);
+        return 0;
+    }
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        cal->offset[i] = (int) flash_read_word(addr + 2 * (1 + i));
+        cal->scale[i] = flash_read_word(addr + 2 * (1 + MAGCAL_AXES + i));
+    }
+    for (int i = 0; i < MAGCAL_WORDS - 1; i++) sum += magcal_word(cal, i);
+    if (flash_read_word(addr + 2 * (MAGCAL_WORDS - 1)) != (unsigned int) ~sum) {
+        magcal_identity(cal);
+        return 0;
+    }
+    return 1;
+}
+
+// erases the reserved page and writes the calibration (takes some tens of ms)
+void magcal_save(const MagCal* cal){
+    unsigned long addr = __builtin_tbladdress(magcal_page);
+    unsigned int words[MAGCAL_WORDS];
+    unsigned int sum = 0;
+
+    for (int i = 0; i < MAGCAL_WORDS - 1; i++) {
+        words[i] = magcal_word(cal, i);
+        sum += words[i];
+    }
+    words[MAGCAL_WORDS - 1] = ~sum;
+
+    flash_erase_page(addr);
+    for (int i = 0; i < MAGCAL_WORDS; i += 2) {
+        flash_write_dword(addr + 2 * i, words[i], words[i + 1]);
+    }
+}
@@ -0,0 +1,71 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MAGCAL_H
+#define	MAGCAL_H
+
+#define MAGCAL_AXES 3
+#define MAGCAL_SCALE_BITS 12 // scales in Q12, 4096 = 1.0
+#define MAGCAL_MIN_SPAN 320  // minimum max - min on every axis to accept a calibration (20uT in 1/16 uT)
+#define MAGCAL_MAX_RATIO 2   // maximum ratio between the ranges of two axes
+
+// hard-iron offset and soft-iron (diagonal) scale of each axis:
+// calibrated = (value - offset) * scale >> MAGCAL_SCALE_BITS
+typedef struct {
+    int offset[MAGCAL_AXES];
+    unsigned int scale[MAGCAL_AXES];
+} MagCal;
+
+// running min/max of the samples collected between $CAL,START and $CAL,STOP
+typedef struct {
+    int min[MAGCAL_AXES];
+    int max[MAGCAL_AXES];
+    unsigned int count;
+} MagCalTracker;
+
+void magcal_identity(MagCal* cal);
+void magcal_apply(const MagCal* cal, int* values);
+void magcal_start(MagCalTracker* tracker);
+void magcal_track(MagCalTracker* tracker, const int* values);
+int magcal_finish(const MagCalTracker* tracker, MagCal* cal);
+int magcal_load(MagCal* cal);
+void magcal_save(const MagCal* cal);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MAGCAL_H */
+
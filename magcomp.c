@@ -0,0 +1,67 @@
+/*
+ * File:   magcomp.c
+ * Author: group 6
+ *
+ * Temperature compensation of the BMX055 magnetometer with the factory trim,
+ * integer version of the Bosch formulas (no floating point).
+ */
+
+#include "magcomp.h"
+
+// overflow codes of the raw registers
+#define MAG_XY_OVERFLOW (-4096)
+#define MAG_Z_OVERFLOW (-16384)
+
+// converts the raw 0x5D-0x71 registers (data[0] is 0x5D)
+void magcomp_unpack_trim(const unsigned char* data, MagTrim* trim){
+    trim->x1 = (signed char) data[0x5D - MAG_TRIM_ADDR];
+    trim->y1 = (signed char) data[0x5E - MAG_TRIM_ADDR];
+    trim->z4 = (short) (((unsigned int) data[0x63 - MAG_TRIM_ADDR] << 8) | data[0x62 - MAG_TRIM_ADDR]);
+    trim->x2 = (signed char) data[0x64 - MAG_TRIM_ADDR];
+    trim->y2 = (signed char) data[0x65 - MAG_TRIM_ADDR];
+    trim->z2 = (short) (((unsigned int) data[0x69 - MAG_TRIM_ADDR] << 8) | data[0x68 - MAG_TRIM_ADDR]);
+    trim->z1 = ((unsigned int) data[0x6B - MAG_TRIM_ADDR] << 8) | data[0x6A - MAG_TRIM_ADDR];
+    trim->xyz1 = ((unsigned int) (data[0x6D - MAG_TRIM_ADDR] & 0x7F) << 8) | data[0x6C - MAG_TRIM_ADDR];
+    trim->z3 = (short) (((unsigned int) data[0x6F - MAG_TRIM_ADDR] << 8) | data[0x6E - MAG_TRIM_ADDR]);
+    trim->xy2 = (signed char) data[0x70 - MAG_TRIM_ADDR];
+    trim->xy1 = data[0x71 - MAG_TRIM_ADDR];
+}
+
+// common part of X and Y: raw * sensitivity(rhall) + offset, x1/x2 are the axis trims
+int magcomp_xy(const MagTrim* trim, int raw, unsigned int rhall, int t1, int t2){
+    long r, s;
+
+    if (raw == MAG_XY_OVERFLOW || rhall == 0 || trim->xyz1 == 0) return MAG_COMP_OVERFLOW;
+
+    r = (long) (unsigned int) (((unsigned long) trim->xyz1 << 14) / rhall) - 0x4000L;
+    s = ((((long) trim->xy2 * ((r * r) >> 7)) + (r * ((long) trim->xy1 << 7))) >> 9) + 0x100000L;
+    s = (s * ((long) t2 + 0xA0)) >> 12;
+    return (int) (((long) raw * s) >> 13) + (t1 << 3);
+}
+
+// compensated X in 1/16 uT, MAG_COMP_OVERFLOW if not available
+int magcomp_x(const MagTrim* trim, int raw_x, unsigned int rhall){
+    return magcomp_xy(trim, raw_x, rhall, trim->x1, trim->x2);
+}
+
+// compensated Y in 1/16 uT, MAG_COMP_OVERFLOW if not available
+int magcomp_y(const MagTrim* trim, int raw_y, unsigned int rhall){
+    return magcomp_xy(trim, raw_y, rhall, trim->y1, trim->y2);
+}
+
+// compensated Z in 1/16 uT (saturated to +-32767), MAG_COMP_OVERFLOW if not available
+int magcomp_z(const MagTrim* trim, int raw_z, unsigned int rhall){
+    long num, den;
+
+    if (raw_z == MAG_Z_OVERFLOW || trim->z1 == 0 || trim->z2 == 0 || rhall == 0 || trim->xyz1 == 0) {
+        return MAG_COMP_OVERFLOW;
+    }
+
+    num = ((long) (raw_z - trim->z4) << 15) - (((long) trim->z3 * ((long) rhall - (long) trim->xyz1)) >> 2);
+    den = trim->z2 + (int) (((long) trim->z1 * ((long) rhall << 1) + (1L << 15)) >> 16);
+    num /= den;
+
+    if (num > 32767) return 32767;
+    if (num < -32767) return -32767;
+    return (int) num;
+}
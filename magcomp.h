@@ -0,0 +1,72 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MAGCOMP_H
+#define	MAGCOMP_H
+
+// trim registers of the BMX055 magnetometer, 0x5D-0x71
+#define MAG_TRIM_ADDR 0x5D
+#define MAG_TRIM_LEN 21
+
+// compensated values are in 1/16 uT
+#define MAG_COMP_FRAC_BITS 4
+#define MAG_COMP_OVERFLOW (-32768) // returned when the raw value is out of range
+
+// factory trim, read once at startup by mag_read_trim()
+typedef struct {
+    signed char x1;
+    signed char y1;
+    signed char x2;
+    signed char y2;
+    unsigned int z1;
+    int z2;
+    int z3;
+    int z4;
+    unsigned char xy1;
+    signed char xy2;
+    unsigned int xyz1;
+} MagTrim;
+
+void magcomp_unpack_trim(const unsigned char* data, MagTrim* trim);
+int magcomp_x(const MagTrim* trim, int raw_x, unsigned int rhall);
+int magcomp_y(const MagTrim* trim, int raw_y, unsigned int rhall);
+int magcomp_z(const MagTrim* trim, int raw_z, unsigned int rhall);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MAGCOMP_H */
+
@@ -0,0 +1,83 @@
+/*
+ * File:   maglog.c
+ * Author: group 6
+ *
+ * RAM burst logger of the raw magnetometer samples. The capture fills a ring
+ * for a given number of samples (the oldest are overwritten if they do not
+ * fit), the dump reads it back from the oldest record.
+ */
+
+#include "maglog.h"
+#include "prof.h"
+#include "timer.h"
+
+MagLogRecord maglog_ring[MAGLOG_RECORDS] __attribute__((far)); // outside the near data (first 8KB)
+unsigned int maglog_head;      // next record written
+unsigned int maglog_stored;    // records in the ring, up to MAGLOG_RECORDS
+unsigned int maglog_remaining; // samples still to capture, 0 = not capturing
+unsigned int maglog_read;      // records already dumped
+unsigned long maglog_last;     // clock of the previous sample
+unsigned int maglog_first_rhall;
+
+// starts a capture of the next samples, the previous one is discarded
+void maglog_start(unsigned int samples){
+    maglog_head = 0;
+    maglog_stored = 0;
+    maglog_read = 0;
+    maglog_remaining = samples;
+}
+
+// stores a sample while capturing. Returns 1 when the capture is complete
+int maglog_add(const MagReading* reading){
+    MagLogRecord* r = &maglog_ring[maglog_head];
+    unsigned long dt;
+
+    if (maglog_remaining == 0) return 0;
+
+    if (maglog_stored == 0) {
+        dt = 0;
+        maglog_first_rhall = reading->sample.rhall; // the temperature compensation needs it
+    }
+    else dt = prof_us(TMR_CLOCK_DIFF(reading->stamp, maglog_last)) / MAGLOG_DT_US;
+    maglog_last = reading->stamp;
+
+    r->x = reading->sample.x;
+    r->y = reading->sample.y;
+    r->z = reading->sample.z;
+    r->dt = (dt > 0xFFFF) ? 0xFFFF : dt;
+    maglog_head = (maglog_head + 1 == MAGLOG_RECORDS) ? 0 : maglog_head + 1;
+    if (maglog_stored < MAGLOG_RECORDS) maglog_stored++;
+
+    return --maglog_remaining == 0;
+}
+
+int maglog_capturing(){
+    return maglog_remaining != 0;
+}
+
+// records kept by the last capture
+unsigned int maglog_count(){
+    return maglog_stored;
+}
+
+// hall resistance of the first sample, the same for the whole burst
+unsigned int maglog_rhall(){
+    return maglog_first_rhall;
+}
+
+// the next maglog_next() returns the oldest record
+void maglog_rewind(){
+    maglog_read = 0;
+}
+
+// the records from the oldest, returns 0 after the last one
+int maglog_next(MagLogRecord* record){
+    unsigned int i;
+
+    if (maglog_read >= maglog_stored) return 0;
+    i = maglog_head + MAGLOG_RECORDS - maglog_stored + maglog_read; // oldest is at head when full
+    if (i >= MAGLOG_RECORDS) i -= MAGLOG_RECORDS;
+    *record = maglog_ring[i];
+    maglog_read++;
+    return 1;
+}
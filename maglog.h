@@ -0,0 +1,70 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MAGLOG_H
+#define	MAGLOG_H
+
+#include "spi.h"
+
+// RAM burst logger: raw magnetometer samples at full rate, too fast for the UART,
+// are kept in RAM during $LOG and sent afterwards by $DUMP.
+// The ring lives in the directly addressable data memory (0x1000-0x7FFF, 28KB):
+// the rest of the firmware uses about 3.5KB (2KB are the UART buffers, the
+// .map reports the total), the remaining ~4.5KB are left to the stack.
+#define MAGLOG_RECORDS 2560 // 20KB, 25.6s at 100Hz
+#define MAGLOG_DT_US 10     // unit of the delta timestamp, up to 655ms between samples
+
+// packed record, 8 bytes: raw x, y, z and the time since the previous sample
+typedef struct {
+    int x;
+    int y;
+    int z;
+    unsigned int dt; // MAGLOG_DT_US units, saturated
+} MagLogRecord;
+
+void maglog_start(unsigned int samples);
+int maglog_add(const MagReading* reading);
+int maglog_capturing();
+unsigned int maglog_count();
+unsigned int maglog_rhall();
+void maglog_rewind();
+int maglog_next(MagLogRecord* record);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MAGLOG_H */
+
@@ -0,0 +1,42 @@
+/*
+ * File:   magstat.c
+ * Author: group 6
+ *
+ * Windowed min/max/mean/variance of each axis with Welford's algorithm
+ * in fixed point.
+ */
+
+#include "magstat.h"
+
+void magstat_reset(MagStat* s){
+    for (int i = 0; i < MAGSTAT_AXES; i++) {
+        s->min[i] = 32767;
+        s->max[i] = -32768;
+        s->mean[i] = 0;
+        s->m2[i] = 0;
+    }
+    s->count = 0;
+}
+
+// adds one sample (one value per axis)
+void magstat_add(MagStat* s, const int* values){
+    s->count++;
+    for (int i = 0; i < MAGSTAT_AXES; i++) {
+        long x = (long) values[i] << MAGSTAT_FRAC_BITS;
+        long delta = x - s->mean[i];
+
+        if (values[i] < s->min[i]) s->min[i] = values[i];
+        if (values[i] > s->max[i]) s->max[i] = values[i];
+        s->mean[i] += delta / (long) s->count;
+        s->m2[i] += (long long) delta * (x - s->mean[i]);
+    }
+}
+
+// sample variance of an axis in Q4 (MAGSTAT_VAR_BITS), 0 with less than two samples
+unsigned long magstat_variance(const MagStat* s, int axis){
+    long long var;
+
+    if (s->count < 2 || s->m2[axis] <= 0) return 0; // the rounding of the mean can make m2 slightly negative
+    var = (s->m2[axis] / (s->count - 1)) >> (2 * MAGSTAT_FRAC_BITS - MAGSTAT_VAR_BITS);
+    return (var > MAGSTAT_VAR_MAX) ? MAGSTAT_VAR_MAX : (unsigned long) var;
+}
@@ -0,0 +1,63 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MAGSTAT_H
+#define	MAGSTAT_H
+
+#define MAGSTAT_AXES 3
+#define MAGSTAT_FRAC_BITS 8  // mean in Q8 of the sample unit, the variance in Q16 while accumulating
+#define MAGSTAT_VAR_BITS 4   // fractional bits of the variance at the end of a window
+#define MAGSTAT_VAR_MAX 400000000UL // variance saturation, printable by fmt_q()
+
+// per-axis statistics of a window of samples, updated incrementally (Welford):
+// no sample is kept, the variance does not suffer from the cancellation of sum(x^2) - n*mean^2
+typedef struct {
+    int min[MAGSTAT_AXES];
+    int max[MAGSTAT_AXES];
+    long mean[MAGSTAT_AXES];    // Q8
+    long long m2[MAGSTAT_AXES]; // sum of the squared deviations, Q16
+    unsigned int count;
+} MagStat;
+
+void magstat_reset(MagStat* s);
+void magstat_add(MagStat* s, const int* values);
+unsigned long magstat_variance(const MagStat* s, int axis);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MAGSTAT_H */
+
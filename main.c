@@ -9,22 +9,57 @@
 #include "spi.h"
 #include "timer.h"
 #include "uart.h"
+#include "fmt.h"
+#include "cordic.h"
+#include "movavg.h"
+#include "magcal.h"
+#include "fusion.h"
+#include "telem.h"
+#include "maglog.h"
+#include "magstat.h"
+#include "cmd.h"
+#include "sched.h"
+#include "prof.h"
 #include <string.h>
-#include "stdio.h"
 #include <stdlib.h>
-#include <math.h>
 
-#define NUM_SAMPLES 5 // Number of samples to average
 // macros for axes
 #define AXIS_X 0
 #define AXIS_Y 1
 #define AXIS_Z 2
+#define AVG_FRAC_BITS 4 // averages are kept in Q4 fixed point (1/16 of the sample unit)
 
-// Finite State Machine (FSM) states for UART communication
-typedef enum {IDLE, S_dollar, S_R, S_A, S_T, S_E, S_comma, S_asterisk} UART_State;
-char receivedXX[3]; // store values for $RATE,xx*
-int success = 0; // flag to check if the value is valid
-UART_State uartState = IDLE; // Initialize the UART state to IDLE
+// maximum length of the frames, used to reserve space in the TX buffer
+// (plus one byte for the 0x00 delimiter in binary mode, see endFrame())
+#define MAG_FRAME_MAX 32 // $MAG,-2048.0,-2048.0,-2048.0*
+#define YAW_FRAME_MAX 13 //  $YAW,359.9*
+
+// $YAW rate in Hz, a divisor of 100 (above 50Hz the frames need more than 9600 baud)
+#define YAW_RATE 10
+#define ERR_FRAME_MAX 7  // $ERR,1*
+#define BAUD_FRAME_MAX 13 // $BAUD,921600*
+
+#define RX_CHUNK 64 // characters moved at once from the RX buffer
+#define STAT_FRAME_MAX 64 // $STAT,name,count,min,mean,max,jitter,overruns* or $HIST,name,h0,...,h7*
+#define LOG_FRAME_MAX 10  // $LOG,2560*
+#define DUMP_FRAME_MAX 27 // $D,65535,-4096,-4096,-16384* or $DUMP,2560,16383,10*
+#define MSTAT_FRAME_MAX 118 // $MSTAT,65535 and ,-2048.0,-2048.0,-2048.0,40000000.0 per axis, *
+
+#define LOG_ODR 100 // magnetometer data rate during $LOG, the fastest preset
+#define LOG_MAX_MS (65535UL * 1000 / LOG_ODR) // longest $LOG, the samples are counted in 16 bits
+
+// parser of the commands received on the UART, see commands[]
+CmdParser cmd_parser;
+
+// $BAUD handshake: the command is acknowledged at the old rate, then the rate
+// changes and the host must repeat the command at the new rate within
+// BAUD_TIMEOUT ticks, otherwise the old rate is restored
+#define BAUD_TIMEOUT 200 // 2s
+typedef enum {BAUD_IDLE, BAUD_ACK, BAUD_CONFIRM} BaudState;
+BaudState baud_state = BAUD_IDLE;
+unsigned long baud_new;
+unsigned long baud_old;
+int baud_ticks;
 
 // circular buffer for TX
 // used to send error messages, magnetometer data and yaw
@@ -34,34 +69,67 @@ CircularBuffer cb_tx;
 // used to receive rate by user
 CircularBuffer cb_rx;
 
-char buffer[32];    // buffer to store strings
-unsigned int read_addr_x = 0x42; // address of X axis
-unsigned int read_addr_y = 0x44; // address of Y axis
-unsigned int read_addr_z = 0x46; // address of Z axis
-unsigned int lsb;
-unsigned int msb;
-unsigned int raw;
-int signed_value;
+MagReading mag_reading; // last sample read from the magnetometer, with its timestamp
+MagTrim mag_trim;       // factory trim of the magnetometer
+MagSample mag_comp;     // last compensated sample, 1/16 uT
+MagCal mag_cal;                 // hard/soft-iron calibration, loaded from flash
+MagCalTracker mag_cal_tracker;  // min/max of the samples during the calibration
+int mag_cal_collecting = 0;     // 1 between $CAL,START* and $CAL,STOP*
 
 int mag_frequency = 5;                 // default frequency 5Hz
-// magnetometer data
-int x_axis_values[NUM_SAMPLES] = {0}; // Array to store last 5 measurement
-int current_index_x = 0;                  // Index to track the oldest measurement
-int samples_collected_x = 0;              // Counter for total samples collected
-int y_axis_values[NUM_SAMPLES] = {0}; // Array to store last 5 measurement
-int current_index_y = 0;                  // Index to track the oldest measurement
-int samples_collected_y = 0;              // Counter for total samples collected
-int z_axis_values[NUM_SAMPLES] = {0}; // Array to store last 5 measurement
-int current_index_z = 0;                  // Index to track the oldest measurement
-int samples_collected_z = 0;              // Counter for total samples collected
-// magnetometer data average values
-double x_avg;
-double y_avg;
-double z_avg;
+const MagOdrPreset* mag_odr;           // data rate of the magnetometer
+
+// 1 after $MODE,BIN*: $MAG and $YAW are sent as binary records (see telem.h)
+int telemetry_binary = 0;
+
+// 1 after $CAP,ON*: every magnetometer sample is sent as a TELEM_RAW record,
+// the capture can be replayed on the host (sim/replay.c)
+int capture_on = 0;
+
+const MagOdrPreset* log_saved_odr; // data rate restored at the end of $LOG
+int dump_state = 0;                // 1 header to send, 2 records to send, 0 no $DUMP in progress
+
+MagStat mag_stat;            // statistics of the current $MSTAT window
+unsigned int mstat_window = 0; // samples per $MSTAT frame, 0 = disabled
+
+// scheduler tasks whose period changes at runtime
+int task_mag_print;
+int task_mag_trigger;
+
+// $STAT dump in progress: $CPU frame, then next task and frame ($STAT or $HIST) to send
+int stat_cpu = 0;
+int stat_task = -1;
+int stat_hist = 0;
+// accelerometer, read every tick for the tilt compensation of the heading
+int acc_present = 0;                     // 0 if the accelerometer did not answer
+SpiTransfer acc_xfer;                    // asynchronous read of the accelerometer data
+int acc_pending = 0;                     // 1 while an accelerometer read is queued or in flight
+unsigned char acc_rx[ACC_DATA_LEN + 1];  // address echo + data registers
+AccSample acc_sample;                    // last accelerometer sample
+MovingAverage acc_avg;                   // gravity, averaged as the magnetic field
+long ax_avg;
+long ay_avg;
+long az_avg;
+
+// gyroscope, read every tick and fused with the magnetometer heading
+int gyr_present = 0;                     // 0 if the gyroscope did not answer
+SpiTransfer gyr_xfer;                    // asynchronous read of the gyroscope data
+int gyr_pending = 0;                     // 1 while a gyroscope read is queued or in flight
+unsigned char gyr_rx[GYR_DATA_LEN + 1];  // address echo + data registers
+GyrSample gyr_sample;                    // last gyroscope sample
+YawFilter yaw_filter;                    // gyro-aided yaw
+int mag_heading = 0;                     // heading of the last magnetometer sample, 0.1 degree
+
+// magnetometer data: moving average over the last MOVAVG_WINDOW samples
+MovingAverage mag_avg;
+// magnetometer data average values in uT, Q8 fixed point (Q4 average of 1/16 uT)
+long x_avg;
+long y_avg;
+long z_avg;
 
 // Interrupt UART RX
 void __attribute__((__interrupt__, __auto_psv__)) _U1RXInterrupt() {
-    char receivedChar = U1RXREG; // reads the received character
+    char receivedChar = hal_uart_get(); // reads the received character
     cb_push(&cb_rx, receivedChar);
     IFS0bits.U1RXIF = 0; // Reset flag interrupt
 }
@@ -74,9 +142,8 @@ void __attribute__((__interrupt__, __auto_psv__)) _U1TXInterrupt() {
     
     while(U1STAbits.UTXBF == 0){
         // If there are characters in the TX buffer, send them
-        if (!cb_is_empty(&cb_tx)) {
-            cb_pop(&cb_tx, &c); // Pop a character from the TX buffer
-            U1TXREG = c;        // Write the character to the UART TX register
+        if (cb_pop(&cb_tx, &c)) {
+            hal_uart_put(c);    // Write the character to the UART TX register
         } else {
             IEC0bits.U1TXIE = 0;
             break;
@@ -84,235 +151,588 @@ void __attribute__((__interrupt__, __auto_psv__)) _U1TXInterrupt() {
     }
 }
 
-// Reads the frequency value specified by the user.
-// performs a check to see if the value is valid.
-// Returns 1 if the value is valid, 0 otherwise.
-// The valid values are 0, 1, 2, 4, 5, and 10.
-int readFrequency(){
-    if(cb_is_empty(&cb_rx)) return 0;
+// completes an ASCII frame. In binary mode (and while capturing) it is followed
+// by a 0x00 too, so that the host can tell it from the binary records
+void endFrame(CbWriter* w){
+    cbw_putc(w, '*');
+    if (telemetry_binary || capture_on) cbw_putc(w, 0);
+    cb_commit(w);
+}
+
+// Function to print an error using protocol $ERR,x*
+void printError(int code){
+    CbWriter w;
     
-    IEC0bits.U1RXIE = 0;   // disable interrupt RX
-    cb_pop(&cb_rx, &receivedXX[1]);
-    IEC0bits.U1RXIE = 1;   // enable interrupt RX
+    if (!cb_reserve(&cb_tx, ERR_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, "$ERR,");
+    fmt_int(&w, code, 0);
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
+
+// period of printMagData in ticks of the algorithm (100/mag_frequency), 0 = disabled
+unsigned int magPrintPeriod() {
+    return (mag_frequency != 0) ? 100 / mag_frequency : 0;
+}
+
+// period of mag_trigger() in ticks, only forced-mode rates need it (0 = disabled)
+unsigned int magTriggerPeriod() {
+    return mag_odr->forced ? 100 / mag_odr->hz : 0;
+}
+
+// reprograms the magnetometer data rate, the acquisition follows:
+// in normal mode DRDY paces the reads, in forced mode the trigger task does
+void setMagOdr(const MagOdrPreset* preset) {
+    mag_odr = preset;
+    mag_set_odr(preset);
+    sched_set_period(task_mag_trigger, magTriggerPeriod());
+}
+
+// sends the factory trim as a TELEM_TRIM record. Returns 0 if the TX buffer is full
+int sendTrimRecord() {
+    int values[11] = {mag_trim.x1, mag_trim.y1, mag_trim.x2, mag_trim.y2, mag_trim.z1, mag_trim.z2,
+                      mag_trim.z3, mag_trim.z4, mag_trim.xy1, mag_trim.xy2, mag_trim.xyz1};
+    
+    return telem_send(&cb_tx, TELEM_TRIM, prof_us(tmr_clock()), values, 11);
+}
+
+// sends the hard/soft-iron calibration as a TELEM_CAL record. Returns 0 if the TX buffer is full
+int sendCalRecord() {
+    int values[2 * MAGCAL_AXES];
     
-    receivedXX[2]='\0';
-    if(strcmp(receivedXX, "00") == 0 || strcmp(receivedXX, "01") == 0 || strcmp(receivedXX, "02") == 0 || 
-            strcmp(receivedXX, "04") == 0 || strcmp(receivedXX, "05") == 0 || strcmp(receivedXX, "10") == 0){        
-        return 1;
+    for (int i = 0; i < MAGCAL_AXES; i++) {
+        values[i] = mag_cal.offset[i];
+        values[MAGCAL_AXES + i] = mag_cal.scale[i];
     }
+    return telem_send(&cb_tx, TELEM_CAL, prof_us(tmr_clock()), values, 2 * MAGCAL_AXES);
+}
+
+// sends a sample as read from the magnetometer, before any compensation
+void captureSample(const MagReading* r) {
+    int values[4] = {r->sample.x, r->sample.y, r->sample.z, r->sample.rhall};
     
-    else return 0;
+    telem_send(&cb_tx, TELEM_RAW, prof_us(r->stamp), values, 4); // lost if the TX buffer is full
+    IEC0bits.U1TXIE = 1; // start transmission
 }
 
-// Handles the UART Finite State Machine (FSM) based on the received character.
-// This function processes the input character received via UART and updates the state of the FSM accordingly.
-// recognizes a specific command format: $RATE,xx*
-void handle_UART_FSM(char receivedChar) {
-    switch (uartState) {
-        case IDLE:
-            if (receivedChar == '$') uartState = S_dollar;            
-            break;
-        case S_dollar:
-            if (receivedChar == 'R') uartState = S_R;
-            else uartState = IDLE;           
-            break;
-        case S_R:
-            if (receivedChar == 'A') uartState = S_A;
-            else uartState = IDLE;           
-            break;
-            
-        case S_A:
-            if (receivedChar == 'T') uartState = S_T;
-            else uartState = IDLE;            
-            break;
-        
-        case S_T:
-            if (receivedChar == 'E') uartState = S_E;
-            else uartState = IDLE;           
-            break; 
-        case S_E:
-            if (receivedChar == ',') uartState = S_comma;
-            else uartState = IDLE;
+// $CAL,START* and $CAL,STOP*: collect the samples while the board is rotated,
+// then compute the calibration and save it in flash
+void handleCalibration(const char* arg) {
+    if (strcmp(arg, "START") == 0) {
+        magcal_start(&mag_cal_tracker);
+        mag_cal_collecting = 1;
+    }
+    else if (strcmp(arg, "STOP") == 0 && mag_cal_collecting) {
+        mag_cal_collecting = 0;
+        if (magcal_finish(&mag_cal_tracker, &mag_cal)) {
+            magcal_save(&mag_cal);
+            if (capture_on) sendCalRecord(); // the samples that follow use the new calibration
+        }
+        else printError(3); // the axes have not been covered
+    }
+    else printError(3);
+}
+
+// acknowledges a $BAUD command with $BAUD,n*
+void printBaud(unsigned long baud){
+    CbWriter w;
+    
+    if (!cb_reserve(&cb_tx, BAUD_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, "$BAUD,");
+    fmt_int(&w, baud, 0);
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
+
+// $BAUD,n*: starts the handshake, or completes it if received at the new rate
+void handleBaud(unsigned long baud){
+    if (baud_state == BAUD_CONFIRM && baud == baud_new) {
+        baud_state = BAUD_IDLE; // the host is talking at the new rate
+        printBaud(baud);
+        return;
+    }
+    if (baud_state != BAUD_IDLE || baud == uart_baud() || !uart_baud_supported(baud)) {
+        printError(5);
+        return;
+    }
+    baud_old = uart_baud();
+    baud_new = baud;
+    baud_state = BAUD_ACK;
+    printBaud(baud);
+}
+
+// periodic task of the $BAUD handshake
+void updateBaud(){
+    switch (baud_state) {
+        case BAUD_ACK:
+            // switch once the acknowledge has been sent at the old rate
+            if (!cb_is_empty(&cb_tx) || !uart_tx_idle()) break;
+            uart_set_baud(baud_new);
+            baud_ticks = BAUD_TIMEOUT;
+            baud_state = BAUD_CONFIRM;
             break;
-        case S_comma:
-            receivedXX[0] = receivedChar;
-            success = readFrequency();
-            
-            if(success) uartState = S_asterisk;
-            else {
-                sprintf(buffer, "$ERR,1*");
-                IEC0bits.U1TXIE = 0;
-                for (int i = 0; i < strlen(buffer); i++) {
-                    cb_push(&cb_tx, buffer[i]);
-                }
-                IEC0bits.U1TXIE = 1;
-                memset(buffer, 0, sizeof(buffer));
-            
-                uartState = IDLE;
-            }
-            
+        case BAUD_CONFIRM:
+            if (--baud_ticks > 0) break;
+            // no valid frame at the new rate: back to the old one
+            uart_set_baud(baud_old);
+            baud_state = BAUD_IDLE;
+            printError(5);
             break;
-        case S_asterisk:
-            if (receivedChar == '*'){
-                mag_frequency = atoi(receivedXX);                
-                /*
-                //Use to debug
-                sprintf(buffer, "$OK - %d*", mag_frequency);
-                IEC0bits.U1TXIE = 0;
-                for (int i = 0; i < strlen(buffer); i++) {
-                    cb_push(&cb_tx, buffer[i]);
-                }
-                IEC0bits.U1TXIE = 1;
-                memset(buffer, 0, sizeof(buffer));                
-                */
-            }
-            
-            uartState = IDLE;
-            break;  
         default:
-            uartState = IDLE;           
-            break;  
+            break;
+    }
+}
+
+// $RATE,xx*: the valid values are 0, 1, 2, 4, 5, and 10 Hz (0 disables $MAG)
+void cmdRate(int argc, const CmdArg* argv) {
+    long hz = argv[0].num;
+    
+    if (hz != 0 && hz != 1 && hz != 2 && hz != 4 && hz != 5 && hz != 10) {
+        printError(1);
+        return;
+    }
+    mag_frequency = hz;
+    sched_set_period(task_mag_print, magPrintPeriod());
+}
+
+// $ODR,xx*: magnetometer data rate, see mag_odr_presets
+void cmdOdr(int argc, const CmdArg* argv) {
+    const MagOdrPreset* preset = mag_find_odr(argv[0].num);
+    
+    if (preset) setMagOdr(preset);
+    else printError(2);
+}
+
+// $CAL,START* and $CAL,STOP*
+void cmdCal(int argc, const CmdArg* argv) {
+    handleCalibration(argv[0].str);
+}
+
+// $MODE,BIN* and $MODE,ASCII*
+void cmdMode(int argc, const CmdArg* argv) {
+    if (strcmp(argv[0].str, "BIN") == 0) telemetry_binary = 1;
+    else if (strcmp(argv[0].str, "ASCII") == 0) telemetry_binary = 0;
+    else printError(4);
+}
+
+// $CAP,ON* and $CAP,OFF*: raw sample capture. It starts with the trim and the
+// calibration, needed to replay the samples
+void cmdCap(int argc, const CmdArg* argv) {
+    if (strcmp(argv[0].str, "ON") == 0) {
+        if (!sendTrimRecord() || !sendCalRecord()) {
+            printError(7); // no room in the TX buffer, retry
+            return;
+        }
+        IEC0bits.U1TXIE = 1; // start transmission
+        capture_on = 1;
     }
+    else if (strcmp(argv[0].str, "OFF") == 0) capture_on = 0;
+    else printError(7);
 }
 
+// end of the $LOG capture: the data rate is restored, $LOG,n* reports the samples kept
+void endLog() {
+    CbWriter w;
+    
+    setMagOdr(log_saved_odr);
+    if (!cb_reserve(&cb_tx, LOG_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, "$LOG,");
+    fmt_int(&w, maglog_count(), 0);
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
+
+// $LOG,ms*: raw samples at the full data rate for ms milliseconds are kept in RAM
+// (the last MAGLOG_RECORDS if they do not fit), see $DUMP
+void cmdLog(int argc, const CmdArg* argv) {
+    unsigned int samples = 0;
+    
+    if (argv[0].num >= 0 && argv[0].num <= (long) LOG_MAX_MS) samples = argv[0].num * LOG_ODR / 1000;
+    if (samples == 0 || dump_state) {
+        printError(8); // shorter than a sample or longer than LOG_MAX_MS
+        return;
+    }
+    if (!maglog_capturing()) log_saved_odr = mag_odr;
+    setMagOdr(mag_find_odr(LOG_ODR));
+    maglog_start(samples);
+}
+
+// $DUMP*: sends the last $LOG capture while the link is idle, see dumpLog()
+void cmdDump(int argc, const CmdArg* argv) {
+    if (maglog_capturing()) {
+        printError(8);
+        return;
+    }
+    maglog_rewind();
+    dump_state = 1;
+}
+
+// $MSTAT,n*: statistics of the calibrated samples every n samples, 0 = disabled
+void cmdMstat(int argc, const CmdArg* argv) {
+    if (argv[0].num == 1 || argv[0].num < 0 || argv[0].num > 65535) {
+        printError(9); // the variance needs two samples, the window is counted in 16 bits
+        return;
+    }
+    mstat_window = argv[0].num;
+    magstat_reset(&mag_stat);
+}
+
+// $BAUD,n*
+void cmdBaud(int argc, const CmdArg* argv) {
+    handleBaud(argv[0].num);
+}
+
+// $STAT*: start the dump, sent by printStats() when there is room in the TX buffer
+void cmdStat(int argc, const CmdArg* argv) {
+    stat_cpu = 1;
+    stat_task = 0;
+    stat_hist = 0;
+}
+
+// commands: name, arguments ('u' number, 's' word), handler, error code for malformed frames
+const CmdEntry commands[] = {
+    {"RATE", "u", cmdRate, 1},
+    {"ODR", "u", cmdOdr, 2},
+    {"CAL", "s", cmdCal, 3},
+    {"MODE", "s", cmdMode, 4},
+    {"BAUD", "u", cmdBaud, 5},
+    {"STAT", "", cmdStat, 0},
+    {"CAP", "s", cmdCap, 7},
+    {"LOG", "u", cmdLog, 8},
+    {"DUMP", "", cmdDump, 0},
+    {"MSTAT", "u", cmdMstat, 9},
+};
+
 // Function that processes characters from the circular buffer
+// the characters are moved in chunks, without disabling the RX interrupt,
+// and parsed in bulk
 void processReceivedData() {
-    char receivedChar;
+    char chunk[RX_CHUNK];
+    unsigned int n;
     
     // If there are characters in the buffer
-    while (!cb_is_empty(&cb_rx)) {
-        IEC0bits.U1RXIE = 0;   // Disable RX interrupt
-        // Pop the character from the buffer
-        cb_pop(&cb_rx, &receivedChar);
-        IEC0bits.U1RXIE = 1;   // Enable RX interrupt
-        
-        handle_UART_FSM(receivedChar); // Handle the character based on the FSM
+    while ((n = cb_pop_n(&cb_rx, chunk, RX_CHUNK)) > 0) {
+        cmd_feed(&cmd_parser, chunk, n);
     }
+    cmd_tick(&cmd_parser); // runs a frame left without checksum
 }
 
-// Function to add a new measurement to the corresponding axis array
-void addMeasurement(int axis, int new_value) {
-    switch(axis) {
-        case AXIS_X:
-            x_axis_values[current_index_x++] = new_value;
-             // Update index to point to the next position (which will be the oldest value)
-            current_index_x = (current_index_x + 1) % NUM_SAMPLES;
-            // Keep track of how many samples we've collected
-            if (samples_collected_x < NUM_SAMPLES) samples_collected_x++;
-            break;
-        case AXIS_Y:
-            y_axis_values[current_index_y++] = new_value;
-            current_index_y = (current_index_y + 1) % NUM_SAMPLES;
-            if (samples_collected_y < NUM_SAMPLES) samples_collected_y++;
-            break;
-        case AXIS_Z:
-            z_axis_values[current_index_z++] = new_value;
-            current_index_z = (current_index_z + 1) % NUM_SAMPLES;
-            if (samples_collected_z < NUM_SAMPLES) samples_collected_z++;
-            break;
-    }
+// Function to add a new measurement of all the axes to the moving average
+void addMeasurement(const MagSample* sample) {
+    int values[MOVAVG_AXES] = {sample->x, sample->y, sample->z};
+    
+    movavg_add(&mag_avg, values);
 }
 
-// function to get magnetometer data of each axis
-// and store it in the corresponding array
-void getMagData(){
-    // X axis
-    spi_write_2_reg(read_addr_x, &lsb, &msb);
-    lsb = lsb & 0x00F8;
-    msb = msb << 8; //left shift by 8
-    raw = msb | lsb; //put together the two bytes
-    //raw = raw >> 3; //right shift by 3
-    signed_value = (int) raw / 8; // right shift by 3 corresponds to dividing by 8
-    addMeasurement(AXIS_X, signed_value); 
-
-    // Y axis
-    spi_write_2_reg(read_addr_y, &lsb, &msb);
-    lsb = lsb & 0x00F8;
-    msb = msb << 8;
-    raw = msb | lsb;
-    signed_value = (int) raw / 8;
-    addMeasurement(AXIS_Y, signed_value);
-    
-    // Z axis
-    spi_write_2_reg(read_addr_z, &lsb, &msb);
-    lsb = lsb & 0x00FE; // for z axis LSB the register bits are different
-    msb = msb << 8;
-    raw = msb | lsb;
-    //signed_value = (int) raw >> 1;
-    signed_value = (int) raw / 2; // right shift by 1 corresponds to dividing by 2
-    addMeasurement(AXIS_Z, signed_value);
-}
-
-// Calculate the average of stored measurements
-float averageMeasurements(int axis) {    
-    float sum = 0;
-    int count = 0;
-    
-     switch(axis) {
-        case AXIS_X:
-            count = samples_collected_x;
-            for (int i = 0; i < count; i++) sum += x_axis_values[i];
-            break;
-        case AXIS_Y:
-            count = samples_collected_y;
-            for (int i = 0; i < count; i++) sum += y_axis_values[i];
-            break;
-        case AXIS_Z:
-            count = samples_collected_z;
-            for (int i = 0; i < count; i++) sum += z_axis_values[i];
-            break;
+// temperature compensation of a sample with the factory trim, in 1/16 uT.
+// Returns 0 if the sample is out of range
+int compensateSample(const MagSample* raw, MagSample* comp) {
+    comp->x = magcomp_x(&mag_trim, raw->x, raw->rhall);
+    comp->y = magcomp_y(&mag_trim, raw->y, raw->rhall);
+    comp->z = magcomp_z(&mag_trim, raw->z, raw->rhall);
+    comp->rhall = raw->rhall;
+
+    return comp->x != MAG_COMP_OVERFLOW && comp->y != MAG_COMP_OVERFLOW && comp->z != MAG_COMP_OVERFLOW;
+}
+
+// hard/soft-iron calibration of a compensated sample, in place.
+// While calibrating the sample is also used to update the min/max
+void calibrateSample(MagSample* sample) {
+    int values[MAGCAL_AXES] = {sample->x, sample->y, sample->z};
+
+    if (mag_cal_collecting) magcal_track(&mag_cal_tracker, values);
+    magcal_apply(&mag_cal, values);
+    sample->x = values[AXIS_X];
+    sample->y = values[AXIS_Y];
+    sample->z = values[AXIS_Z];
+}
+
+// Function to print the statistics of a window of calibrated samples using protocol
+// $MSTAT,n,xmin,xmax,xmean,xvar,ymin,...,zvar* (uT, variance in LSB^2 where 1 LSB = 1/16 uT)
+void printMagStats(){
+    CbWriter w;
+    
+    if (!cb_reserve(&cb_tx, MSTAT_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, "$MSTAT,");
+    fmt_int(&w, mag_stat.count, 0);
+    for (int axis = 0; axis < MAGSTAT_AXES; axis++) {
+        cbw_putc(&w, ',');
+        fmt_q(&w, mag_stat.min[axis], MAG_COMP_FRAC_BITS, 0);
+        cbw_putc(&w, ',');
+        fmt_q(&w, mag_stat.max[axis], MAG_COMP_FRAC_BITS, 0);
+        cbw_putc(&w, ',');
+        fmt_q(&w, mag_stat.mean[axis], MAGSTAT_FRAC_BITS + MAG_COMP_FRAC_BITS, 0);
+        cbw_putc(&w, ',');
+        fmt_q(&w, magstat_variance(&mag_stat, axis), MAGSTAT_VAR_BITS, 0);
     }
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
+
+// adds a calibrated sample to the $MSTAT window, the frame is sent when it is complete
+void updateMagStats(const MagSample* sample) {
+    int values[MAGSTAT_AXES] = {sample->x, sample->y, sample->z};
     
-    // Return the average
-    return (count == 0) ? 0 : sum / count;
+    magstat_add(&mag_stat, values);
+    if (mag_stat.count >= mstat_window) {
+        printMagStats();
+        magstat_reset(&mag_stat);
+    }
+}
+
+// compensation, calibration and moving average of a sample read from the magnetometer.
+// Returns 0 if the sample is out of range
+int processMagSample(const MagSample* raw) {
+    if (!compensateSample(raw, &mag_comp)) return 0;
+    calibrateSample(&mag_comp);
+    addMeasurement(&mag_comp);
+    if (mstat_window) updateMagStats(&mag_comp);
+    return 1;
+}
+
+// add the samples read since the last call to the moving average.
+// The magnetometer is read by the DRDY interrupt at its own data rate (see mag_drdy_init()).
+// Returns 1 if at least a new sample has been stored
+int storeMagData(){
+    int stored = 0;
+
+    while (mag_pop(&mag_reading)) {
+        if (capture_on) captureSample(&mag_reading);
+        if (maglog_capturing() && maglog_add(&mag_reading)) endLog();
+        if (processMagSample(&mag_reading.sample)) stored = 1;
+    }
+    return stored;
+}
+
+// Calculate the average of stored measurements in Q4 fixed point
+long averageMeasurements(int axis) {    
+    return movavg_get(&mag_avg, axis, AVG_FRAC_BITS);
 }
 
 // Function to print magnetometer data using protocol $MAG,x,y,z*
+// the frame is formatted directly in the TX buffer.
+// In binary mode a TELEM_MAG record in 1/16 uT is sent instead
 void printMagData(){    
-    sprintf(buffer, "$MAG,%.1f,%.1f,%.1f*", x_avg,y_avg,z_avg);
-
-    IEC0bits.U1TXIE = 0;
-    for (int i = 0; i < strlen(buffer); i++) {
-        cb_push(&cb_tx, buffer[i]);
+    CbWriter w;
+    
+    if (telemetry_binary) {
+        int values[3] = {x_avg >> AVG_FRAC_BITS, y_avg >> AVG_FRAC_BITS, z_avg >> AVG_FRAC_BITS};
+        
+        telem_send(&cb_tx, TELEM_MAG, prof_us(mag_reading.stamp), values, 3);
+        IEC0bits.U1TXIE = 1; // start transmission
+        return;
     }
-    IEC0bits.U1TXIE = 1;
+    
+    if (!cb_reserve(&cb_tx, MAG_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, "$MAG,");
+    fmt_q(&w, x_avg, AVG_FRAC_BITS + MAG_COMP_FRAC_BITS, 0); // uT
+    cbw_putc(&w, ',');
+    fmt_q(&w, y_avg, AVG_FRAC_BITS + MAG_COMP_FRAC_BITS, 0); // uT
+    cbw_putc(&w, ',');
+    fmt_q(&w, z_avg, AVG_FRAC_BITS + MAG_COMP_FRAC_BITS, 0); // uT
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
 }
 
 // Function to print yaw angle using protocol $YAW,xx*
+// gyro-aided yaw, or the magnetometer heading alone without the gyroscope,
+// in tenths of degree (0-359.9)
 void printYawAngle(){
-    double heading_rad = atan2(y_avg, x_avg);
-    double heading_deg = heading_rad * (180.0 / M_PI); // Convert to degrees
+    int heading = gyr_present ? fusion_yaw(&yaw_filter) : mag_heading;
+    CbWriter w;
+    
+    if (telemetry_binary) {
+        telem_send(&cb_tx, TELEM_YAW, prof_us(tmr_clock()), &heading, 1);
+        IEC0bits.U1TXIE = 1; // start transmission
+        return;
+    }
+    
+    if (!cb_reserve(&cb_tx, YAW_FRAME_MAX + 1, &w)) return; // TX buffer full, skip
+    cbw_puts(&w, " $YAW,");
+    fmt_tenths(&w, heading, 0);
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
 
-    if (heading_deg < 0)
-        heading_deg += 360.0; // Normalize to 0-360
+// Function to print the CPU utilisation since the previous $STAT:
+// $CPU,load,busy,idle* (load in %, busy and idle time in ms)
+void printCpuLoad(CbWriter* w){
+    unsigned long busy, idle;
+    unsigned int load = tmr_cpu_load(&busy, &idle);
     
-    sprintf(buffer, " $YAW,%.1f*", heading_deg);
+    cbw_puts(w, "$CPU,");
+    fmt_tenths(w, load, 0);
+    cbw_putc(w, ',');
+    fmt_int(w, prof_us(busy) / 1000, 0);
+    cbw_putc(w, ',');
+    fmt_int(w, prof_us(idle) / 1000, 0);
+}
 
-    IEC0bits.U1TXIE = 0;
-    for (int i = 0; i < strlen(buffer); i++) {
-        cb_push(&cb_tx, buffer[i]);
+// Function to print the profiler statistics of the tasks, one frame per call:
+// $CPU,load,busy,idle* first, then for each task
+// $STAT,name,count,min,mean,max,jitter,overruns* (times in us)
+// $HIST,name,h0,...,h7* (execution time histogram, see PROF_BINS)
+void printStats(){
+    CbWriter w;
+    ProfStat* p;
+    
+    if (stat_task < 0) return; // no dump requested
+    if (stat_task >= sched_count()) {
+        stat_task = -1; // dump complete
+        return;
+    }
+    if (!cb_reserve(&cb_tx, STAT_FRAME_MAX + 1, &w)) return; // TX buffer full, retry at the next tick
+    
+    p = prof_stat(stat_task);
+    if (stat_cpu) {
+        printCpuLoad(&w);
+        stat_cpu = 0;
+    } else if (!stat_hist) {
+        cbw_puts(&w, "$STAT,");
+        cbw_puts(&w, sched_task(stat_task)->name);
+        cbw_putc(&w, ',');
+        fmt_int(&w, p->count, 0);
+        cbw_putc(&w, ',');
+        fmt_int(&w, p->count ? prof_us(p->min) : 0, 0);
+        cbw_putc(&w, ',');
+        fmt_int(&w, p->count ? prof_us(p->sum / p->count) : 0, 0);
+        cbw_putc(&w, ',');
+        fmt_int(&w, prof_us(p->max), 0);
+        cbw_putc(&w, ',');
+        fmt_int(&w, (p->count > 1) ? prof_us(p->period_max - p->period_min) : 0, 0);
+        cbw_putc(&w, ',');
+        fmt_int(&w, sched_task(stat_task)->overruns, 0);
+        stat_hist = 1;
+    } else {
+        cbw_puts(&w, "$HIST,");
+        cbw_puts(&w, sched_task(stat_task)->name);
+        for (int i = 0; i < PROF_BINS; i++) {
+            cbw_putc(&w, ',');
+            fmt_int(&w, p->hist[i], 0);
+        }
+        stat_hist = 0;
+        stat_task++;
+    }
+    endFrame(&w);
+    IEC0bits.U1TXIE = 1; // start transmission
+}
+
+// Function to send the $DUMP capture: $DUMP,n,rhall,dt_us* first, then
+// $D,dt,x,y,z* for each sample (raw values, dt in units of dt_us).
+// The frames are sent only when the telemetry has left the TX buffer,
+// at most what the UART sends in a tick (at least a frame)
+void dumpLog(){
+    unsigned int budget = UART_TICK_CHARS(uart_baud());
+    MagLogRecord r;
+    CbWriter w;
+    
+    if (!dump_state || !cb_is_empty(&cb_tx)) return; // nothing to send or link busy
+    
+    if (budget < DUMP_FRAME_MAX + 1) budget = DUMP_FRAME_MAX + 1;
+    while (cb_count(&cb_tx) + DUMP_FRAME_MAX + 1 <= budget && cb_reserve(&cb_tx, DUMP_FRAME_MAX + 1, &w)) {
+        if (dump_state == 1) {
+            cbw_puts(&w, "$DUMP,");
+            fmt_int(&w, maglog_count(), 0);
+            cbw_putc(&w, ',');
+            fmt_int(&w, maglog_rhall(), 0);
+            cbw_putc(&w, ',');
+            fmt_int(&w, MAGLOG_DT_US, 0);
+            dump_state = 2;
+        } else {
+            if (!maglog_next(&r)) {
+                cb_commit(&w); // releases the reserved space
+                dump_state = 0; // dump complete
+                break;
+            }
+            cbw_puts(&w, "$D,");
+            fmt_int(&w, r.dt, 0);
+            cbw_putc(&w, ',');
+            fmt_int(&w, r.x, 0);
+            cbw_putc(&w, ',');
+            fmt_int(&w, r.y, 0);
+            cbw_putc(&w, ',');
+            fmt_int(&w, r.z, 0);
+        }
+        endFrame(&w);
+        IEC0bits.U1TXIE = 1; // start transmission (not on an empty buffer: the flag would be lost)
     }
-    IEC0bits.U1TXIE = 1;
 }
 
 // periodic function that runs for 7ms
+// (the CPU waits in Idle, see tmr_wait_ms())
 void algorithm() {
     tmr_wait_ms(TIMER2, 7);
 }
 
-int main(void) {
-    ANSELA = ANSELB = ANSELC = ANSELD = ANSELE = ANSELG = 0x0000; // disable analog inputs
+// blink LED2
+void blinkLed() {
+    LATGbits.LATG9 = !LATGbits.LATG9;
+}
+
+// update the averages and the heading after new samples.
+// The heading is tilt-compensated when the accelerometer is available
+// and corrects the gyro-aided yaw
+void updateHeading() {
+    x_avg = averageMeasurements(AXIS_X);
+    y_avg = averageMeasurements(AXIS_Y);
+    z_avg = averageMeasurements(AXIS_Z);
+
+    if (acc_present) mag_heading = cordic_heading(x_avg, y_avg, z_avg, ax_avg, ay_avg, az_avg);
+    else mag_heading = cordic_atan2(y_avg, x_avg);
+    fusion_correct(&yaw_filter, mag_heading);
+}
+
+// store the sample read during the previous ticks and update the averages
+void updateMagData() {
+    if(storeMagData()) updateHeading();
+}
+
+// takes the accelerometer sample read in the previous tick and starts the next read
+void updateAccData() {
+    int values[MOVAVG_AXES];
+    
+    if (acc_pending) {
+        if (!acc_xfer.done) return; // still in flight
+        
+        acc_unpack_sample(&acc_rx[1], &acc_sample);
+        values[AXIS_X] = acc_sample.x;
+        values[AXIS_Y] = acc_sample.y;
+        values[AXIS_Z] = acc_sample.z;
+        movavg_add(&acc_avg, values);
+        ax_avg = movavg_get(&acc_avg, AXIS_X, AVG_FRAC_BITS);
+        ay_avg = movavg_get(&acc_avg, AXIS_Y, AVG_FRAC_BITS);
+        az_avg = movavg_get(&acc_avg, AXIS_Z, AVG_FRAC_BITS);
+    }
     
-    //variables
-    int ret;    // variable to check if the algorithm has missed a deadline
-    int i = 0; // variable to count 50 ticks (500ms)
-    int count_magPrint = 0; // counter to sincronize printMagData at the specified rate
-    int count_getMagData = 0; // counter to sincronize getMagData at 25Hz
-    int count_yaw = 0; // counter to sincronize print yaw angle at 5Hz
+    acc_pending = spi_submit(&acc_xfer);
+}
+
+// integrates the gyroscope z rate read in the previous tick and starts the next read
+void updateGyrData() {
+    if (gyr_pending) {
+        if (!gyr_xfer.done) return; // still in flight
+        
+        gyr_unpack_sample(&gyr_rx[1], &gyr_sample);
+        fusion_predict(&yaw_filter, gyr_sample.z);
+    }
     
-    // optional: print missed deadlines
-    //int missed_deadlines = 0; // variable to count missed deadlines of algorithm
-    //int count_dead = 0; // counter to sincronize print missed deadlines
+    gyr_pending = spi_submit(&gyr_xfer);
+}
+
+// registers a task, see sched_add(). A full task table is a configuration error
+// (raise PROF_MAX): the firmware stops with LED2 on instead of running without the task
+int addTask(const char* name, void (*run)(void), unsigned int period, unsigned int phase, unsigned int budget_us) {
+    int id = sched_add(name, run, period, phase, budget_us);
+    
+    if (id < 0) {
+        LATGbits.LATG9 = 1;
+        while (1) Idle();
+    }
+    return id;
+}
+
+int main(void) {
+    ANSELA = ANSELB = ANSELC = ANSELD = ANSELE = ANSELG = 0x0000; // disable analog inputs
     
     TRISGbits.TRISG9 = 0; // LED2 output
     LATGbits.LATG9 = 0; // switch off LED2 at the beginning
@@ -322,70 +742,45 @@ int main(void) {
     // Make the magnetometer switch to Sleep mode; then make it go to active mode; 
     // data rate = 25Hz
     mag_enable();
+    mag_read_trim(&mag_trim); // factory trim for the temperature compensation
+    magcal_load(&mag_cal);    // hard/soft-iron calibration, identity if never calibrated
+    acc_present = acc_enable(); // +-2g, 125Hz
+    gyr_present = gyr_enable(); // +-250deg/s, 100Hz
+    
+    spi_dma_init(); // from now on the sensors are read asynchronously
+    acc_prepare_read(&acc_xfer, acc_rx);
+    gyr_prepare_read(&gyr_xfer, gyr_rx);
+    fusion_init(&yaw_filter);
     
     UART1_Init(); // initialize UART1
     
     cb_init(&cb_tx);
     cb_init(&cb_rx);
+    movavg_init(&mag_avg);
+    cmd_init(&cmd_parser, commands, sizeof(commands) / sizeof(commands[0]), printError);
+    movavg_init(&acc_avg);
+    magstat_reset(&mag_stat);
     
-    tmr_setup_period(TIMER1, 10); // Timer 1 for algorithm() - 100 Hz = 10ms
-    while(1){
-        algorithm();
-        
-        // after 50 ticks (500ms) blink LED2
-        i++;
-        if (i == 50) {
-            i = 0;
-            LATGbits.LATG9 = !LATGbits.LATG9; // blink LED2
-        }
-               
-        processReceivedData();
-        
-        count_getMagData++;
-        // get magnetometer data at 25Hz
-        // every 4 ticks of the algorithm (4*10ms = 40ms)
-        if(count_getMagData == 4){
-            count_getMagData = 0;
-            getMagData();
-            x_avg = averageMeasurements(AXIS_X);
-            y_avg = averageMeasurements(AXIS_Y);
-            z_avg = averageMeasurements(AXIS_Z);
-        }
-        
-        count_magPrint++;
-        // print magnetometer data at mag_frequency
-        // every 100/mag_frequency ticks of the algorithm
-        if(mag_frequency!=0 && count_magPrint >= (100/mag_frequency)){
-            count_magPrint = 0;
-            printMagData();        
-        }
-        
-        count_yaw++;
-        // print yaw angle at 5Hz
-        // every 20 ticks of the algorithm (20*10ms = 200ms)
-        if(count_yaw == 20){
-            count_yaw = 0;
-            printYawAngle();
-        }
-
-        ret = tmr_wait_period(TIMER1);
-        
-        // OPTIONAL: print missed deadlines of algorithm
-        /*
-        if(ret) missed_deadlines++;
-        count_dead++;
-        // every 500 ticks of the algorithm (500*10ms = 5s)
-        if(count_dead==500){
-            count_dead=0;
-            sprintf(buffer, "$MISS%d*", missed_deadlines);
-
-            IEC0bits.U1TXIE = 0;
-            for (int i = 0; i < strlen(buffer); i++) {
-                cb_push(&cb_tx, buffer[i]);
-            }
-            IEC0bits.U1TXIE = 1;
-        }
-        */
-    }
+    sched_init(10); // Timer 1 for algorithm() - 100 Hz = 10ms
+    mag_drdy_init(); // the magnetometer is read as soon as a sample is ready
+    
+    // tasks: function, period [ticks], phase [ticks], budget [us]
+    // tasks with an automatic phase are spread over the ticks with the least load
+    addTask("ALG", algorithm, 1, 0, 7100);
+    addTask("RX", processReceivedData, 1, 0, 300);
+    addTask("MAGST", updateMagData, 1, 0, 200);
+    if (acc_present) addTask("ACC", updateAccData, 1, 0, 150);
+    if (gyr_present) addTask("GYR", updateGyrData, 1, 0, 150);
+    mag_odr = mag_find_odr(25);
+    task_mag_trigger = addTask("MAGTR", mag_trigger, magTriggerPeriod(), 0, 50); // forced mode only
+    setMagOdr(mag_odr); // 25Hz
+    task_mag_print = addTask("MAG", printMagData, magPrintPeriod(), SCHED_AUTO_PHASE, 500);
+    addTask("YAW", printYawAngle, 100 / YAW_RATE, SCHED_AUTO_PHASE, 300);
+    addTask("LED", blinkLed, 50, SCHED_AUTO_PHASE, 20);                        // 500ms
+    addTask("STAT", printStats, 1, 0, 400);
+    addTask("BAUD", updateBaud, 1, 0, 50);
+    addTask("DUMP", dumpLog, 1, 0, 300);
+    
+    sched_run();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+/*
+ * File:   movavg.c
+ * Author: group 6
+ *
+ * Incremental moving average with a compile-time power-of-two window.
+ */
+
+#include "movavg.h"
+
+void movavg_init(MovingAverage *ma){
+    for (int axis = 0; axis < MOVAVG_AXES; axis++) {
+        for (int i = 0; i < MOVAVG_WINDOW; i++) ma->samples[axis][i] = 0;
+        ma->sum[axis] = 0;
+    }
+    ma->index = 0;
+    ma->count = 0;
+}
+
+// adds one sample (one value per axis), replacing the oldest one
+void movavg_add(MovingAverage *ma, const int *values){
+    unsigned int i = ma->index;
+
+    for (int axis = 0; axis < MOVAVG_AXES; axis++) {
+        ma->sum[axis] += (long) values[axis] - ma->samples[axis][i]; // the difference may not fit an int
+        ma->samples[axis][i] = values[axis];
+    }
+
+    ma->index = (i + 1) & MOVAVG_MASK;
+    if (ma->count < MOVAVG_WINDOW) ma->count++;
+}
+
+// average of an axis in fixed point with frac_bits fractional bits.
+// Once the window is full this is a shift; while it is filling up
+// the sum is divided by the number of samples collected
+long movavg_get(MovingAverage *ma, int axis, int frac_bits){
+    if (ma->count == 0) return 0;
+    if (ma->count == MOVAVG_WINDOW) return (ma->sum[axis] << frac_bits) >> MOVAVG_WINDOW_LOG2;
+    return (ma->sum[axis] << frac_bits) / (long) ma->count;
+}
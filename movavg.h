@@ -0,0 +1,67 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef MOVAVG_H
+#define	MOVAVG_H
+
+// window length as a power of two, chosen at compile time
+#ifndef MOVAVG_WINDOW_LOG2
+#define MOVAVG_WINDOW_LOG2 2 // 4 samples
+#endif
+#define MOVAVG_WINDOW (1 << MOVAVG_WINDOW_LOG2)
+#define MOVAVG_MASK (MOVAVG_WINDOW - 1)
+
+#define MOVAVG_AXES 3 // number of axes averaged together
+
+// multi-axis moving average over the last MOVAVG_WINDOW samples.
+// The running sum of each axis is updated by adding the new sample and
+// subtracting the one it replaces, so the cost does not depend on the window.
+typedef struct {
+    int samples[MOVAVG_AXES][MOVAVG_WINDOW]; // one array per axis
+    long sum[MOVAVG_AXES];                   // running sum of each axis
+    unsigned int index;                      // slot of the oldest sample
+    unsigned int count;                      // samples collected, up to MOVAVG_WINDOW
+} MovingAverage;
+
+void movavg_init(MovingAverage *ma);
+void movavg_add(MovingAverage *ma, const int *values);
+long movavg_get(MovingAverage *ma, int axis, int frac_bits);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MOVAVG_H */
+
@@ -51,17 +51,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=uart.c timer.c spi.c main.c
+SOURCEFILES_QUOTED_IF_SPACED=uart.c timer.c spi.c main.c fmt.c cordic.c movavg.c sched.c prof.c magcomp.c flash.c magcal.c fusion.c spibus.c telem.c cmd.c maglog.c magstat.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/uart.o ${OBJECTDIR}/timer.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/main.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/uart.o.d ${OBJECTDIR}/timer.o.d ${OBJECTDIR}/spi.o.d ${OBJECTDIR}/main.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/uart.o ${OBJECTDIR}/timer.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/main.o ${OBJECTDIR}/fmt.o ${OBJECTDIR}/cordic.o ${OBJECTDIR}/movavg.o ${OBJECTDIR}/sched.o ${OBJECTDIR}/prof.o ${OBJECTDIR}/magcomp.o ${OBJECTDIR}/flash.o ${OBJECTDIR}/magcal.o ${OBJECTDIR}/fusion.o ${OBJECTDIR}/spibus.o ${OBJECTDIR}/telem.o ${OBJECTDIR}/cmd.o ${OBJECTDIR}/maglog.o ${OBJECTDIR}/magstat.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/uart.o.d ${OBJECTDIR}/timer.o.d ${OBJECTDIR}/spi.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/fmt.o.d ${OBJECTDIR}/cordic.o.d ${OBJECTDIR}/movavg.o.d ${OBJECTDIR}/sched.o.d ${OBJECTDIR}/prof.o.d ${OBJECTDIR}/magcomp.o.d ${OBJECTDIR}/flash.o.d ${OBJECTDIR}/magcal.o.d ${OBJECTDIR}/fusion.o.d ${OBJECTDIR}/spibus.o.d ${OBJECTDIR}/telem.o.d ${OBJECTDIR}/cmd.o.d ${OBJECTDIR}/maglog.o.d ${OBJECTDIR}/magstat.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/uart.o ${OBJECTDIR}/timer.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/main.o
+OBJECTFILES=${OBJECTDIR}/uart.o ${OBJECTDIR}/timer.o ${OBJECTDIR}/spi.o ${OBJECTDIR}/main.o ${OBJECTDIR}/fmt.o ${OBJECTDIR}/cordic.o ${OBJECTDIR}/movavg.o ${OBJECTDIR}/sched.o ${OBJECTDIR}/prof.o ${OBJECTDIR}/magcomp.o ${OBJECTDIR}/flash.o ${OBJECTDIR}/magcal.o ${OBJECTDIR}/fusion.o ${OBJECTDIR}/spibus.o ${OBJECTDIR}/telem.o ${OBJECTDIR}/cmd.o ${OBJECTDIR}/maglog.o ${OBJECTDIR}/magstat.o
 
 # Source Files
-SOURCEFILES=uart.c timer.c spi.c main.c
+SOURCEFILES=uart.c timer.c spi.c main.c fmt.c cordic.c movavg.c sched.c prof.c magcomp.c flash.c magcal.c fusion.c spibus.c telem.c cmd.c maglog.c magstat.c
 
 
 
@@ -113,6 +113,90 @@ ${OBJECTDIR}/main.o: main.c  .generated_files/flags/default/297fa401d5265d99992b
 	@${RM} ${OBJECTDIR}/main.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE)  main.c  -o ${OBJECTDIR}/main.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/main.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
 	
+${OBJECTDIR}/fmt.o: fmt.c  .generated_files/flags/default/07d1ebc7c7f301d7f726fe92296722951333c850 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fmt.o.d 
+	@${RM} ${OBJECTDIR}/fmt.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  fmt.c  -o ${OBJECTDIR}/fmt.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/fmt.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/cordic.o: cordic.c  .generated_files/flags/default/128f80603781cec60d6a8854a06f762594ef0de0 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/cordic.o.d 
+	@${RM} ${OBJECTDIR}/cordic.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  cordic.c  -o ${OBJECTDIR}/cordic.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/cordic.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/movavg.o: movavg.c  .generated_files/flags/default/aee22d0383a2a57c220db5a2676a252c1cfa3fe9 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/movavg.o.d 
+	@${RM} ${OBJECTDIR}/movavg.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  movavg.c  -o ${OBJECTDIR}/movavg.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/movavg.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sched.o: sched.c  .generated_files/flags/default/78293001f0f3c25387f879a1f4b712b7491e4fa0 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sched.o.d 
+	@${RM} ${OBJECTDIR}/sched.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sched.c  -o ${OBJECTDIR}/sched.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sched.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/prof.o: prof.c  .generated_files/flags/default/8e906c8b1c2db17d45dff7e15be54112cf27733a .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/prof.o.d 
+	@${RM} ${OBJECTDIR}/prof.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  prof.c  -o ${OBJECTDIR}/prof.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/prof.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magcomp.o: magcomp.c  .generated_files/flags/default/6687396b024955f681a5a86ab5a09be3841f4860 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magcomp.o.d 
+	@${RM} ${OBJECTDIR}/magcomp.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magcomp.c  -o ${OBJECTDIR}/magcomp.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magcomp.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/flash.o: flash.c  .generated_files/flags/default/edba6921e9d53fb82c417d852f04d710d2194a8e .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/flash.o.d 
+	@${RM} ${OBJECTDIR}/flash.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  flash.c  -o ${OBJECTDIR}/flash.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/flash.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magcal.o: magcal.c  .generated_files/flags/default/b76738d4ff35c0aea8654e739fe707dd2c142dd0 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magcal.o.d 
+	@${RM} ${OBJECTDIR}/magcal.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magcal.c  -o ${OBJECTDIR}/magcal.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magcal.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/fusion.o: fusion.c  .generated_files/flags/default/c8059a0038dcf564580c310424d1ddc31bdda9ac .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fusion.o.d 
+	@${RM} ${OBJECTDIR}/fusion.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  fusion.c  -o ${OBJECTDIR}/fusion.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/fusion.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/spibus.o: spibus.c  .generated_files/flags/default/4983c57ce8e0f8775a3410b0fa564f217db804d7 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/spibus.o.d 
+	@${RM} ${OBJECTDIR}/spibus.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  spibus.c  -o ${OBJECTDIR}/spibus.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/spibus.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/telem.o: telem.c  .generated_files/flags/default/42d28413cdeb742b4286e044df9af0eea9d70d27 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/telem.o.d 
+	@${RM} ${OBJECTDIR}/telem.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  telem.c  -o ${OBJECTDIR}/telem.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/telem.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/cmd.o: cmd.c  .generated_files/flags/default/50d6795adb36c0736a4b81eceb36ee84f0dd1041 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/cmd.o.d 
+	@${RM} ${OBJECTDIR}/cmd.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  cmd.c  -o ${OBJECTDIR}/cmd.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/cmd.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/maglog.o: maglog.c  .generated_files/flags/default/33e16107ec68dc3b9bd44c3d509d4e409e59443c .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/maglog.o.d 
+	@${RM} ${OBJECTDIR}/maglog.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  maglog.c  -o ${OBJECTDIR}/maglog.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/maglog.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magstat.o: magstat.c  .generated_files/flags/default/ee30776b194e74fdebe123876e59a2b2b507f944 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magstat.o.d 
+	@${RM} ${OBJECTDIR}/magstat.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magstat.c  -o ${OBJECTDIR}/magstat.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magstat.o.d"      -g -D__DEBUG   -mno-eds-warn  -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
 else
 ${OBJECTDIR}/uart.o: uart.c  .generated_files/flags/default/44de9493202595e5ef9d25667bc05b4535e1bf95 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
 	@${MKDIR} "${OBJECTDIR}" 
@@ -138,6 +222,90 @@ ${OBJECTDIR}/main.o: main.c  .generated_files/flags/default/34a677376ec4333f8b57
 	@${RM} ${OBJECTDIR}/main.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE)  main.c  -o ${OBJECTDIR}/main.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/main.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
 	
+${OBJECTDIR}/fmt.o: fmt.c  .generated_files/flags/default/79286eac5c27b5370fd08833f9323ac43cab4d01 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fmt.o.d 
+	@${RM} ${OBJECTDIR}/fmt.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  fmt.c  -o ${OBJECTDIR}/fmt.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/fmt.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/cordic.o: cordic.c  .generated_files/flags/default/31aa0ab8d968c08c9a91360c88745555a7a987e1 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/cordic.o.d 
+	@${RM} ${OBJECTDIR}/cordic.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  cordic.c  -o ${OBJECTDIR}/cordic.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/cordic.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/movavg.o: movavg.c  .generated_files/flags/default/730ab50ab3710c9f2fd909721cbc922d465fcc61 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/movavg.o.d 
+	@${RM} ${OBJECTDIR}/movavg.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  movavg.c  -o ${OBJECTDIR}/movavg.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/movavg.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sched.o: sched.c  .generated_files/flags/default/58b48b4d69148e7ee84de6fd00dcb7f7a74a1701 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sched.o.d 
+	@${RM} ${OBJECTDIR}/sched.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sched.c  -o ${OBJECTDIR}/sched.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sched.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/prof.o: prof.c  .generated_files/flags/default/3c102783856d81c39c09b6d5747b59af40e39fce .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/prof.o.d 
+	@${RM} ${OBJECTDIR}/prof.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  prof.c  -o ${OBJECTDIR}/prof.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/prof.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magcomp.o: magcomp.c  .generated_files/flags/default/1cc32e987492ba2716b18ddebd16d4ac2f0fb05c .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magcomp.o.d 
+	@${RM} ${OBJECTDIR}/magcomp.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magcomp.c  -o ${OBJECTDIR}/magcomp.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magcomp.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/flash.o: flash.c  .generated_files/flags/default/86eacdf16291629e2dedfe65de12601d907c9b7e .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/flash.o.d 
+	@${RM} ${OBJECTDIR}/flash.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  flash.c  -o ${OBJECTDIR}/flash.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/flash.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magcal.o: magcal.c  .generated_files/flags/default/5ab3f2ff04ba122ef9eeb22c5dbbe6f4354ad240 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magcal.o.d 
+	@${RM} ${OBJECTDIR}/magcal.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magcal.c  -o ${OBJECTDIR}/magcal.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magcal.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/fusion.o: fusion.c  .generated_files/flags/default/b07c8a2fca36c49153af699c4b621c4abe9f1c8f .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fusion.o.d 
+	@${RM} ${OBJECTDIR}/fusion.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  fusion.c  -o ${OBJECTDIR}/fusion.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/fusion.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/spibus.o: spibus.c  .generated_files/flags/default/e564128527c8592ad56f7f36f4155d1a3b8730c8 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/spibus.o.d 
+	@${RM} ${OBJECTDIR}/spibus.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  spibus.c  -o ${OBJECTDIR}/spibus.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/spibus.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/telem.o: telem.c  .generated_files/flags/default/635a405dd69360781ef214455ebbc66128bbc05c .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/telem.o.d 
+	@${RM} ${OBJECTDIR}/telem.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  telem.c  -o ${OBJECTDIR}/telem.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/telem.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/cmd.o: cmd.c  .generated_files/flags/default/a7cd6c5cfebcff087fddfc0488f7dad5ed6af7db .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/cmd.o.d 
+	@${RM} ${OBJECTDIR}/cmd.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  cmd.c  -o ${OBJECTDIR}/cmd.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/cmd.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/maglog.o: maglog.c  .generated_files/flags/default/829409a65de5e3b0734501f752d60a7d97a00226 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/maglog.o.d 
+	@${RM} ${OBJECTDIR}/maglog.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  maglog.c  -o ${OBJECTDIR}/maglog.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/maglog.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/magstat.o: magstat.c  .generated_files/flags/default/589a4ed9f3ec8baa2d13f465c6e75507dce5aae0 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/magstat.o.d 
+	@${RM} ${OBJECTDIR}/magstat.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  magstat.c  -o ${OBJECTDIR}/magstat.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/magstat.o.d"      -mno-eds-warn  -g -omf=elf -DXPRJ_default=$(CND_CONF)    $(COMPARISON_BUILD)  -msmall-data -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
 endif
 
 # ------------------------------------------------------------------------------------
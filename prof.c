@@ -0,0 +1,74 @@
+/*
+ * File:   prof.c
+ * Author: group 6
+ *
+ * Execution time and jitter profiler based on the free-running
+ * TIMER4/TIMER5 clock.
+ */
+
+#include "prof.h"
+
+ProfStat prof_stats[PROF_MAX];
+
+void prof_init(){
+    tmr_start_clock();
+    for (int id = 0; id < PROF_MAX; id++) prof_reset(id);
+}
+
+void prof_reset(int id){
+    ProfStat* p = &prof_stats[id];
+
+    p->start = 0;
+    p->prev_start = 0;
+    p->count = 0;
+    p->min = 0xFFFFFFFFUL;
+    p->max = 0;
+    p->sum = 0;
+    p->period_min = 0xFFFFFFFFUL;
+    p->period_max = 0;
+    for (int i = 0; i < PROF_BINS; i++) p->hist[i] = 0;
+}
+
+// to be called at the entry of the function
+void prof_begin(int id){
+    ProfStat* p = &prof_stats[id];
+    unsigned long period;
+
+    p->start = tmr_clock();
+
+    // interval between two entries, its spread is the jitter
+    if (p->count > 0) {
+        period = TMR_CLOCK_DIFF(p->start, p->prev_start);
+        if (period < p->period_min) p->period_min = period;
+        if (period > p->period_max) p->period_max = period;
+    }
+    p->prev_start = p->start;
+}
+
+// to be called at the exit of the function
+void prof_end(int id){
+    ProfStat* p = &prof_stats[id];
+    unsigned long elapsed = TMR_CLOCK_DIFF(tmr_clock(), p->start);
+    unsigned long us = prof_us(elapsed);
+    int bin = 0;
+
+    p->count++;
+    p->sum += elapsed;
+    if (elapsed < p->min) p->min = elapsed;
+    if (elapsed > p->max) p->max = elapsed;
+
+    us >>= 4; // <16us -> bin 0
+    while (us != 0 && bin < PROF_BINS - 1) {
+        us >>= 2;
+        bin++;
+    }
+    if (p->hist[bin] != 0xFFFF) p->hist[bin]++;
+}
+
+ProfStat* prof_stat(int id){
+    return &prof_stats[id];
+}
+
+unsigned long prof_us(unsigned long counts){
+    return counts / TMR_CLOCK_PER_US;
+}
@@ -0,0 +1,145 @@
+/*
+ * File:   sched.c
+ * Author: group 6
+ *
+ * Table-driven cooperative scheduler paced by TIMER1.
+ * Each tick runs the tasks that are due, measuring their execution time
+ * with TMR1, which counts from the beginning of the period, for the budget
+ * accounting; every run is also recorded by the profiler.
+ */
+
+#include "sched.h"
+
+SchedTask sched_tasks[SCHED_MAX_TASKS];
+int sched_num_tasks = 0;
+unsigned int sched_tick_ms = 10;
+unsigned int sched_missed = 0;
+
+// sets up TIMER1 with the tick period
+void sched_init(int tick_ms){
+    sched_tick_ms = tick_ms;
+    sched_num_tasks = 0;
+    sched_missed = 0;
+    prof_init();
+    tmr_setup_period(TIMER1, tick_ms);
+}
+
+// converts microseconds to TIMER1 counts, PR1 + 1 counts are one tick
+unsigned int sched_us_to_counts(unsigned int us){
+    return (unsigned int) (((unsigned long) us * (PR1 + 1UL)) / (sched_tick_ms * 1000UL));
+}
+
+unsigned int sched_gcd(unsigned int a, unsigned int b){
+    unsigned int t;
+
+    while (b != 0) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// chooses the phase that overlaps the least budget of the tasks already registered.
+// Two tasks meet on some tick iff their phases are congruent modulo gcd(periods)
+unsigned int sched_pick_phase(unsigned int period){
+    unsigned int best = 0;
+    unsigned long best_load = 0xFFFFFFFFUL;
+
+    for (unsigned int p = 0; p < period; p++) {
+        unsigned long load = 0;
+
+        for (int j = 0; j < sched_num_tasks; j++) {
+            unsigned int g;
+
+            if (sched_tasks[j].period == 0) continue;
+            g = sched_gcd(period, sched_tasks[j].period);
+            if ((p % g) == (sched_tasks[j].phase % g)) load += sched_tasks[j].budget;
+        }
+        if (load < best_load) {
+            best_load = load;
+            best = p;
+        }
+    }
+    return best;
+}
+
+// registers a task. Returns its id, or -1 if the table is full
+int sched_add(const char* name, void (*run)(void), unsigned int period, unsigned int phase, unsigned int budget_us){
+    SchedTask* t;
+
+    if (sched_num_tasks == SCHED_MAX_TASKS) return -1;
+
+    t = &sched_tasks[sched_num_tasks];
+    t->name = name;
+    t->run = run;
+    t->period = period;
+    t->budget = sched_us_to_counts(budget_us);
+    if (period == 0) t->phase = 0;
+    else if (phase == SCHED_AUTO_PHASE) t->phase = sched_pick_phase(period);
+    else t->phase = phase % period;
+    t->counter = t->phase;
+    t->last = 0;
+    t->worst = 0;
+    t->overruns = 0;
+
+    return sched_num_tasks++;
+}
+
+// changes the period of a task (0 disables it), keeping its phase.
+// Ignored if id is not a registered task (e.g. -1 from a failed sched_add())
+void sched_set_period(int id, unsigned int period){
+    SchedTask* t;
+
+    if (id < 0 || id >= sched_num_tasks) return;
+    t = &sched_tasks[id];
+    t->period = period;
+    if (period != 0) {
+        t->phase = t->phase % period;
+        t->counter = t->phase;
+    }
+}
+
+SchedTask* sched_task(int id){
+    return &sched_tasks[id];
+}
+
+int sched_count(){
+    return sched_num_tasks;
+}
+
+// runs the tasks due in this tick, in registration order
+void sched_tick(){
+    unsigned int start, end, elapsed;
+
+    for (int i = 0; i < sched_num_tasks; i++) {
+        SchedTask* t = &sched_tasks[i];
+
+        if (t->period == 0) continue;
+        if (t->counter != 0) {
+            t->counter--;
+            continue;
+        }
+        t->counter = t->period - 1;
+
+        prof_begin(i);
+        start = TMR1;
+        t->run();
+        end = TMR1;
+        prof_end(i);
+        elapsed = end - start;
+        if (end < start) elapsed += PR1 + 1; // the period expired while running
+
+        t->last = elapsed;
+        if (elapsed > t->worst) t->worst = elapsed;
+        if (elapsed > t->budget) t->overruns++;
+    }
+}
+
+// main loop: one sched_tick() per TIMER1 period
+void sched_run(){
+    while (1) {
+        sched_tick();
+        if (tmr_wait_period(TIMER1)) sched_missed++;
+    }
+}
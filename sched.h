@@ -0,0 +1,75 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef SCHED_H
+#define	SCHED_H
+
+#include <xc.h> // include processor files - each processor file is guarded.  
+#include "timer.h"
+#include "prof.h"
+
+#define SCHED_MAX_TASKS PROF_MAX // every task is profiled
+#define SCHED_AUTO_PHASE 0xFFFF // let the scheduler choose the phase
+
+// periodic task: runs every period ticks, at ticks where (tick - phase) % period == 0
+typedef struct {
+    const char* name;      // short name, used in the statistics
+    void (*run)(void);
+    unsigned int period;   // in ticks, 0 = disabled
+    unsigned int phase;    // offset within the period, in ticks
+    unsigned int budget;   // worst-case execution time, in TIMER1 counts
+    unsigned int counter;  // ticks until the next release
+    unsigned int last;     // execution time of the last run, in TIMER1 counts
+    unsigned int worst;    // longest execution time, in TIMER1 counts
+    unsigned int overruns; // runs that took longer than the budget
+} SchedTask;
+
+void sched_init(int tick_ms);
+int sched_add(const char* name, void (*run)(void), unsigned int period, unsigned int phase, unsigned int budget_us);
+void sched_set_period(int id, unsigned int period);
+SchedTask* sched_task(int id);
+int sched_count();
+unsigned int sched_us_to_counts(unsigned int us);
+void sched_tick();
+void sched_run();
+
+extern unsigned int sched_missed; // ticks whose tasks did not complete within the period
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* SCHED_H */
+
@@ -0,0 +1,112 @@
+/*
+ * File:   cordic_test.c
+ * Author: group 6
+ *
+ * Host accuracy test of the integer CORDIC against libm:
+ * cordic_atan2() over the full circle at several magnitudes (bound of
+ * cordic.h), and cordic_heading() with the board tilted by up to +-40
+ * degrees of roll and pitch. Exit status 1 if a bound is exceeded.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "cordic.h"
+
+#define ATAN2_MAX_ERROR 0.053 // degrees, see cordic_atan2()
+#define HEADING_MAX_ERROR 0.1 // degrees from the level heading, one unit of the result
+#define EPSILON 1e-9          // the results are in tenths: 0.1 itself is within the bound
+#define TILT_MAX 40           // degrees of roll and pitch
+
+// difference of two headings in degrees, -180..180
+double angle_diff(double a, double b){
+    double d = fmod(a - b, 360.0);
+
+    if (d > 180.0) d -= 360.0;
+    if (d < -180.0) d += 360.0;
+    return d;
+}
+
+double deg(double rad){
+    return rad * 180.0 / M_PI;
+}
+
+double rad(double deg){
+    return deg * M_PI / 180.0;
+}
+
+// atan2 of integer vectors from magnitude 16 (the documented minimum) to 2^20
+double test_atan2(void){
+    static const double magnitudes[] = {16, 100, 1000, 32767, 1 << 20};
+    double worst = 0;
+
+    for (unsigned int m = 0; m < sizeof(magnitudes) / sizeof(magnitudes[0]); m++) {
+        for (int step = 0; step < 36000; step++) {
+            double a = rad(step * 0.01);
+            long x = lround(magnitudes[m] * cos(a));
+            long y = lround(magnitudes[m] * sin(a));
+            double expected = deg(atan2((double) y, (double) x));
+            double err = fabs(angle_diff(cordic_atan2(y, x) / 10.0, expected));
+
+            if (err > worst) worst = err;
+            if (err > ATAN2_MAX_ERROR + EPSILON) {
+                printf("cordic_atan2(%ld, %ld) = %.1f, atan2 %.4f\n", y, x, cordic_atan2(y, x) / 10.0, expected);
+                return worst;
+            }
+        }
+    }
+    return worst;
+}
+
+// the field and gravity as measured by a board tilted by roll (about x) and
+// pitch (about y), body = Rx(roll) * Ry(pitch) * world: the order in which
+// cordic_heading() derotates them. Scales of main.c: 1/16 uT and 1/1024 g in Q4
+double test_heading(void){
+    const double h_field = 20 * 256, v_field = 40 * 256, gravity = 1024 * 16;
+    double worst = 0;
+
+    for (int heading = 0; heading < 360; heading += 5) {
+        for (int roll = -TILT_MAX; roll <= TILT_MAX; roll += 5) {
+            for (int pitch = -TILT_MAX; pitch <= TILT_MAX; pitch += 5) {
+                double w[2][3] = {
+                    {h_field * cos(rad(heading)), h_field * sin(rad(heading)), v_field},
+                    {0, 0, gravity},
+                };
+                double cr = cos(rad(roll)), sr = sin(rad(roll));
+                double cp = cos(rad(pitch)), sp = sin(rad(pitch));
+                long b[2][3];
+                double err;
+                int result;
+
+                for (int v = 0; v < 2; v++) {
+                    double x = cp * w[v][0] + sp * w[v][2]; // Ry(pitch)
+                    double z = -sp * w[v][0] + cp * w[v][2];
+                    double y = w[v][1];
+
+                    b[v][0] = lround(x); // Rx(roll)
+                    b[v][1] = lround(cr * y - sr * z);
+                    b[v][2] = lround(sr * y + cr * z);
+                }
+                result = cordic_heading(b[0][0], b[0][1], b[0][2], b[1][0], b[1][1], b[1][2]);
+                err = fabs(angle_diff(result / 10.0, heading));
+                if (err > worst) worst = err;
+                if (err > HEADING_MAX_ERROR + EPSILON) {
+                    printf("cordic_heading: heading %d roll %d pitch %d -> %.1f\n", heading, roll, pitch, result / 10.0);
+                    return worst;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+int main(void){
+    double atan2_error = test_atan2();
+    double heading_error = test_heading();
+    int failed = atan2_error > ATAN2_MAX_ERROR + EPSILON || heading_error > HEADING_MAX_ERROR + EPSILON;
+
+    printf("cordic_atan2: max error %.4f degrees (bound %.3f)\n", atan2_error, ATAN2_MAX_ERROR);
+    printf("cordic_heading: max error %.4f degrees with +-%d degrees of tilt (bound %.1f)\n",
+           heading_error, TILT_MAX, HEADING_MAX_ERROR);
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed;
+}
@@ -0,0 +1,75 @@
+#
+# Host (x86 Linux) build of the firmware against the simulated device of sim/.
+# The firmware sources are compiled unchanged with HAL_HOST defined, <xc.h>
+# resolves to sim/xc.h and main() is renamed firmware_main.
+#
+#     make host                      builds dist/host/ES_assignment.host
+#     make host PROFILE=1            instrumented for gprof
+#     dist/host/ES_assignment.host -n 100000 -o /dev/null
+#     gprof dist/host/ES_assignment.host gmon.out
+#     make host-test                 accuracy of the CORDIC against libm (sim/cordic_test.c)
+#
+# Replay of a raw sample capture through the magnetometer processing:
+#
+#     echo '$CAP,ON*' > cap.in
+#     dist/host/ES_assignment.host -n 3000 -r 30 -i cap.in -o capture.bin
+#     dist/host/replay -o golden.txt capture.bin      once, before a change
+#     dist/host/replay -g golden.txt capture.bin      after: samples/s and differences
+#
+# A capture of the board ($CAP,ON* with tools/telemetry_decode.py --raw) is replayed the same way.
+#
+# NOCDDL
+
+CC = gcc
+CFLAGS = -std=gnu99 -O2 -g -Wall -Wno-attributes -DHAL_HOST -I. -Isim
+LDLIBS = -lm
+ifeq ($(PROFILE),1)
+CFLAGS += -pg -fno-inline
+LDFLAGS += -pg
+endif
+
+OBJDIR = build/host
+TARGET = dist/host/ES_assignment.host
+REPLAY = dist/host/replay
+CORDIC_TEST = dist/host/cordic_test
+
+FIRMWARE = $(wildcard *.c)
+SIM = sim/sim.c sim/sim_main.c
+OBJECTS = $(addprefix $(OBJDIR)/, $(FIRMWARE:.c=.o) $(notdir $(SIM:.c=.o)))
+REPLAY_OBJECTS = $(filter-out $(OBJDIR)/sim_main.o, $(OBJECTS)) $(OBJDIR)/replay.o
+
+host: $(TARGET) $(REPLAY) $(CORDIC_TEST)
+
+$(TARGET): $(OBJECTS)
+	@mkdir -p $(dir $@)
+	$(CC) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+$(REPLAY): $(REPLAY_OBJECTS)
+	@mkdir -p $(dir $@)
+	$(CC) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+$(CORDIC_TEST): $(OBJDIR)/cordic_test.o $(OBJDIR)/cordic.o
+	@mkdir -p $(dir $@)
+	$(CC) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+host-test: $(CORDIC_TEST)
+	$(CORDIC_TEST)
+
+$(OBJDIR)/main.o: main.c
+	@mkdir -p $(OBJDIR)
+	$(CC) $(CFLAGS) -Dmain=firmware_main -MMD -c -o $@ $<
+
+$(OBJDIR)/%.o: %.c
+	@mkdir -p $(OBJDIR)
+	$(CC) $(CFLAGS) -MMD -c -o $@ $<
+
+$(OBJDIR)/%.o: sim/%.c
+	@mkdir -p $(OBJDIR)
+	$(CC) $(CFLAGS) -MMD -c -o $@ $<
+
+host-clean:
+	rm -rf $(OBJDIR) $(dir $(TARGET))
+
+.PHONY: host host-clean host-test
+
+-include $(OBJECTS:.o=.d) $(OBJDIR)/replay.d $(OBJDIR)/cordic_test.d
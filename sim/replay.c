@@ -0,0 +1,274 @@
+/*
+ * File:   replay.c
+ * Author: group 6
+ *
+ * Offline replay of a raw sample capture ($CAP,ON*, see telem.h) through the
+ * magnetometer processing of the firmware: compensation, calibration, moving
+ * average and heading. The trim and the calibration are taken from the
+ * capture, the gyroscope and the accelerometer are not replayed.
+ * Prints one line per sample (stamp, averages, heading), the throughput of
+ * the processing and, with -g, the differences against a golden output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "spi.h"
+#include "magcomp.h"
+#include "magcal.h"
+#include "movavg.h"
+#include "fusion.h"
+#include "telem.h"
+
+// firmware state and processing, main.c
+extern MagTrim mag_trim;
+extern MagCal mag_cal;
+extern MovingAverage mag_avg;
+extern YawFilter yaw_filter;
+extern long x_avg, y_avg, z_avg;
+extern int mag_heading;
+extern int acc_present, gyr_present;
+int processMagSample(const MagSample* raw);
+void updateHeading(void);
+
+#define REPLAY_FRAME_MAX 256
+#define REPLAY_LINE_MAX 96
+
+typedef struct {
+    unsigned long stamp;
+    MagSample sample;
+} ReplaySample;
+
+ReplaySample* samples;
+unsigned long n_samples, n_cap;
+unsigned long n_ascii, n_corrupt;
+int have_trim, have_cal;
+
+// decodes a COBS frame in place, returns the decoded length or -1 if malformed
+int cobs_decode(unsigned char* buf, int len){
+    int in = 0, out = 0;
+
+    while (in < len) {
+        int code = buf[in++];
+
+        if (code == 0 || in + code - 1 > len) return -1;
+        for (int i = 1; i < code; i++) buf[out++] = buf[in++];
+        if (code < 0xFF && in < len) buf[out++] = 0;
+    }
+    return out;
+}
+
+// a record of the capture: type, sequence, stamp, values, CRC
+void handle_record(unsigned char* r, int len){
+    int n = (len - TELEM_RAW_LEN(0)) / 2;
+    unsigned long stamp = r[2] | (unsigned long) r[3] << 8 | (unsigned long) r[4] << 16 | (unsigned long) r[5] << 24;
+    int v[TELEM_MAX_VALUES];
+
+    for (int i = 0; i < n && i < TELEM_MAX_VALUES; i++) v[i] = (short) (r[6 + 2 * i] | r[7 + 2 * i] << 8);
+
+    if (r[0] == TELEM_RAW && n == 4) {
+        if (n_samples == n_cap) {
+            n_cap = n_cap ? 2 * n_cap : 4096;
+            samples = realloc(samples, n_cap * sizeof(*samples));
+        }
+        samples[n_samples].stamp = stamp;
+        samples[n_samples].sample.x = v[0];
+        samples[n_samples].sample.y = v[1];
+        samples[n_samples].sample.z = v[2];
+        samples[n_samples].sample.rhall = (unsigned short) v[3];
+        n_samples++;
+    }
+    else if (r[0] == TELEM_TRIM && n == 11) {
+        mag_trim.x1 = v[0];
+        mag_trim.y1 = v[1];
+        mag_trim.x2 = v[2];
+        mag_trim.y2 = v[3];
+        mag_trim.z1 = (unsigned short) v[4];
+        mag_trim.z2 = v[5];
+        mag_trim.z3 = v[6];
+        mag_trim.z4 = v[7];
+        mag_trim.xy1 = v[8];
+        mag_trim.xy2 = v[9];
+        mag_trim.xyz1 = (unsigned short) v[10];
+        have_trim = 1;
+    }
+    else if (r[0] == TELEM_CAL && n == 2 * MAGCAL_AXES && !n_samples) {
+        // a calibration sent in the middle of the capture ($CAL,STOP*) is not replayed
+        for (int i = 0; i < MAGCAL_AXES; i++) {
+            mag_cal.offset[i] = v[i];
+            mag_cal.scale[i] = (unsigned short) v[MAGCAL_AXES + i];
+        }
+        have_cal = 1;
+    }
+}
+
+// decodes a frame and checks its CRC. Returns the record length, 0 if not a record
+int decode_record(unsigned char* frame, int len){
+    unsigned char buf[REPLAY_FRAME_MAX];
+    int raw_len;
+
+    memcpy(buf, frame, len);
+    raw_len = cobs_decode(buf, len);
+    if (raw_len < TELEM_RAW_LEN(0)) return 0;
+    if (telem_crc16(buf, raw_len - 2) != (buf[raw_len - 2] | buf[raw_len - 1] << 8)) return 0;
+    memcpy(frame, buf, raw_len);
+    return raw_len;
+}
+
+// splits the stream at the 0x00 delimiters; the ASCII frames ("...*") are skipped.
+// The frames sent before $CAP,ON* have no delimiter and precede the first record
+void load_capture(FILE* in){
+    unsigned char frame[REPLAY_FRAME_MAX];
+    int len = 0, c;
+
+    while ((c = fgetc(in)) != EOF) {
+        if (c != 0) {
+            if (len < REPLAY_FRAME_MAX) frame[len] = c;
+            len++;
+            continue;
+        }
+        if (len > 0 && len <= REPLAY_FRAME_MAX) {
+            int raw_len = decode_record(frame, len);
+
+            // otherwise an ASCII frame, or ASCII frames followed by a record
+            for (int i = 0; !raw_len && i < len - 1; i++) {
+                if (frame[i] == '*' && (raw_len = decode_record(frame + i + 1, len - i - 1))) {
+                    memmove(frame, frame + i + 1, raw_len);
+                }
+            }
+            if (raw_len) handle_record(frame, raw_len);
+            else if (frame[len - 1] == '*') n_ascii++;
+            else n_corrupt++;
+        }
+        else if (len > 0) n_corrupt++;
+        len = 0;
+    }
+}
+
+void replay_reset(void){
+    movavg_init(&mag_avg);
+    fusion_init(&yaw_filter);
+    x_avg = y_avg = z_avg = 0;
+    mag_heading = 0;
+}
+
+// one pass over the samples; the output lines are kept only if out is given
+void replay_pass(char* out){
+    replay_reset();
+    for (unsigned long i = 0; i < n_samples; i++) {
+        if (processMagSample(&samples[i].sample)) updateHeading();
+        if (out) {
+            snprintf(out + i * REPLAY_LINE_MAX, REPLAY_LINE_MAX, "%lu %ld %ld %ld %d\n",
+                     samples[i].stamp, x_avg, y_avg, z_avg, mag_heading);
+        }
+    }
+}
+
+// compares the output with the golden file, line by line. Returns the number of differences
+unsigned long diff_golden(const char* out, const char* golden_name){
+    FILE* golden = fopen(golden_name, "r");
+    char line[REPLAY_LINE_MAX];
+    unsigned long diffs = 0, i = 0;
+
+    if (!golden) {
+        perror(golden_name);
+        exit(2);
+    }
+    for (; fgets(line, sizeof(line), golden); i++) {
+        const char* mine = i < n_samples ? out + i * REPLAY_LINE_MAX : "";
+
+        if (strcmp(line, mine) == 0) continue;
+        if (diffs++ < 10) fprintf(stderr, "sample %lu:\n- %s+ %s%s", i, line, mine, *mine ? "" : "\n");
+    }
+    if (i != n_samples) {
+        fprintf(stderr, "golden has %lu samples, capture %lu\n", i, n_samples);
+        if (i < n_samples) diffs += n_samples - i;
+    }
+    fclose(golden);
+    return diffs;
+}
+
+double host_seconds(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void usage(const char* name){
+    fprintf(stderr,
+            "usage: %s [-k passes] [-o output] [-g golden] capture\n"
+            "  -k  passes over the samples for the timing (default 100)\n"
+            "  -o  writes the output of the replay ('-' for stdout)\n"
+            "  -g  compares the output with a golden file, exit status 1 if different\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv){
+    const char *out_name = 0, *golden_name = 0;
+    unsigned long passes = 100;
+    char* out;
+    double start, host;
+    FILE* in;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:o:g:h")) != -1) {
+        switch (opt) {
+            case 'k':
+                passes = strtoul(optarg, 0, 10);
+                break;
+            case 'o':
+                out_name = optarg;
+                break;
+            case 'g':
+                golden_name = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1) usage(argv[0]);
+    if (!(in = fopen(argv[optind], "rb"))) {
+        perror(argv[optind]);
+        return 2;
+    }
+    load_capture(in);
+    fclose(in);
+    fprintf(stderr, "%lu samples, %lu ASCII frames, %lu corrupt\n", n_samples, n_ascii, n_corrupt);
+    if (!have_trim || !have_cal || !n_samples) {
+        fprintf(stderr, "%s: no trim, calibration or samples, not a $CAP,ON* capture\n", argv[optind]);
+        return 2;
+    }
+
+    acc_present = gyr_present = 0; // heading from the magnetometer alone
+    out = malloc(n_samples * REPLAY_LINE_MAX);
+    replay_pass(out);
+
+    start = host_seconds();
+    for (unsigned long k = 0; k < passes; k++) replay_pass(0);
+    host = host_seconds() - start;
+    if (passes) {
+        fprintf(stderr, "%lu passes in %.3f s: %.0f samples/s\n",
+                passes, host, host > 0 ? passes * n_samples / host : 0.0);
+    }
+
+    if (out_name) {
+        FILE* f = strcmp(out_name, "-") ? fopen(out_name, "w") : stdout;
+
+        if (!f) {
+            perror(out_name);
+            return 2;
+        }
+        for (unsigned long i = 0; i < n_samples; i++) fputs(out + i * REPLAY_LINE_MAX, f);
+        if (f != stdout) fclose(f);
+    }
+    if (golden_name) {
+        unsigned long diffs = diff_golden(out, golden_name);
+
+        fprintf(stderr, "%s: %lu differences\n", golden_name, diffs);
+        return diffs ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,737 @@
+/*
+ * File:   sim.c
+ * Author: group 6
+ *
+ * Simulated device of the host build: registers, timers, UART1, SPI1 with
+ * DMA0/DMA1, INT1, program flash, and the BMX055 on the bus (magnetometer
+ * with DRDY, accelerometer, gyroscope). The board turns at a constant yaw
+ * rate in the Earth field; the magnetometer factory trim is chosen so that
+ * the compensated field is 5/16 uT per raw LSB.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "xc.h"
+
+#define SIM_NEVER 0xFFFFFFFFFFFFFFFFULL
+#define SIM_US(us) ((unsigned long long) (us) * (SIM_FCY / 1000000ULL))
+
+// field of the simulated site, uT: horizontal towards north, vertical downwards
+#define SIM_FIELD_H 20.0
+#define SIM_FIELD_V 40.0
+#define SIM_MAG_LSB (5.0 / 16.0) // uT per raw LSB with the trim below
+#define SIM_RHALL 6000
+#define SIM_GYR_LSB 131.2        // LSB per deg/s, +-250 deg/s range
+#define SIM_ACC_1G 1024          // LSB per g, +-2g range
+
+// registers
+volatile union sim_SPI1STAT_u sim_SPI1STAT;
+volatile union sim_SPI1CON1_u sim_SPI1CON1;
+volatile unsigned int SPI1BUF;
+volatile union sim_TRISA_u sim_TRISA;
+volatile union sim_TRISB_u sim_TRISB;
+volatile union sim_TRISD_u sim_TRISD;
+volatile union sim_TRISE_u sim_TRISE;
+volatile union sim_TRISF_u sim_TRISF;
+volatile union sim_TRISG_u sim_TRISG;
+volatile union sim_LATB_u sim_LATB;
+volatile union sim_LATD_u sim_LATD;
+volatile union sim_LATG_u sim_LATG;
+volatile union sim_PORTE_u sim_PORTE;
+volatile unsigned int ANSELA, ANSELB, ANSELC, ANSELD, ANSELE, ANSELG;
+volatile union sim_RPINR0_u sim_RPINR0;
+volatile union sim_RPINR18_u sim_RPINR18;
+volatile union sim_RPINR20_u sim_RPINR20;
+volatile union sim_RPOR0_u sim_RPOR0;
+volatile union sim_RPOR11_u sim_RPOR11;
+volatile union sim_RPOR12_u sim_RPOR12;
+volatile unsigned int T1CON, T2CON, T3CON, T4CON, T5CON;
+volatile unsigned int TMR1, TMR2, TMR3, TMR4, TMR5, TMR3HLD, TMR5HLD;
+volatile unsigned int PR1, PR2, PR3, PR4, PR5;
+volatile union sim_IFS0_u sim_IFS0;
+volatile union sim_IFS1_u sim_IFS1;
+volatile union sim_IEC0_u sim_IEC0;
+volatile union sim_IEC1_u sim_IEC1;
+volatile union sim_INTCON2_u sim_INTCON2;
+volatile union sim_SR_u sim_SR;
+volatile union sim_U1MODE_u sim_U1MODE;
+volatile union sim_U1STA_u sim_U1STA;
+volatile unsigned int U1BRG, U1TXREG, U1RXREG;
+volatile union sim_DMA0CON_u sim_DMA0CON;
+volatile union sim_DMA1CON_u sim_DMA1CON;
+volatile union sim_DMA0REQ_u sim_DMA0REQ;
+volatile union sim_DMA1REQ_u sim_DMA1REQ;
+volatile unsigned int DMA0STAL, DMA0STAH, DMA0PAD, DMA0CNT;
+volatile unsigned int DMA1STAL, DMA1STAH, DMA1PAD, DMA1CNT;
+volatile union sim_NVMCON_u sim_NVMCON;
+volatile unsigned int NVMADR, NVMADRU, TBLPAG;
+
+SimOptions sim_options = {1000, 0, 0, 0.0, 2, 0};
+SimStats sim_stats;
+
+unsigned long long sim_now = 0; // cycles since reset
+int sim_in_isr = 0;
+
+// interrupt handlers of the firmware
+void _INT1Interrupt(void);
+void _DMA1Interrupt(void);
+void _T1Interrupt(void);
+void _T2Interrupt(void);
+void _T3Interrupt(void);
+void _T4Interrupt(void);
+void _T5Interrupt(void);
+void _U1RXInterrupt(void);
+void _U1TXInterrupt(void);
+
+// interrupt sources in order of natural priority, all at the default level 4
+typedef struct {
+    volatile unsigned int* ifs;
+    volatile unsigned int* iec;
+    unsigned int mask;
+    void (*handler)(void);
+} SimIrq;
+
+const SimIrq sim_irqs[] = {
+    {&IFS1, &IEC1, 1 << 4, _INT1Interrupt},
+    {&IFS0, &IEC0, 1 << 3, _T1Interrupt},
+    {&IFS0, &IEC0, 1 << 7, _T2Interrupt},
+    {&IFS0, &IEC0, 1 << 8, _T3Interrupt},
+    {&IFS0, &IEC0, 1 << 11, _U1RXInterrupt},
+    {&IFS0, &IEC0, 1 << 12, _U1TXInterrupt},
+    {&IFS0, &IEC0, 1 << 14, _DMA1Interrupt},
+    {&IFS1, &IEC1, 1 << 11, _T4Interrupt},
+    {&IFS1, &IEC1, 1 << 12, _T5Interrupt},
+};
+#define SIM_IRQS (sizeof(sim_irqs) / sizeof(sim_irqs[0]))
+#define SIM_IRQ_LEVEL 4
+
+/* ---------------------------------------------------------------- timers */
+
+#define TCON_TON 0x8000
+#define TCON_T32 0x0008
+
+typedef struct {
+    volatile unsigned int* con;
+    volatile unsigned int* tmr;
+    volatile unsigned int* pr;
+    volatile unsigned int* hld;   // TMRxHLD of the upper timer of the pair, 0 if none
+    volatile unsigned int* ifs;
+    unsigned int mask;
+    int slave;                    // upper timer in 32-bit mode, 0 if none
+} SimTimerRegs;
+
+const SimTimerRegs sim_timer_regs[6] = {
+    {0, 0, 0, 0, 0, 0, 0},
+    {&T1CON, &TMR1, &PR1, 0, &IFS0, 1 << 3, 0},
+    {&T2CON, &TMR2, &PR2, 0, &IFS0, 1 << 7, 3},
+    {&T3CON, &TMR3, &PR3, &TMR3HLD, &IFS0, 1 << 8, 0},
+    {&T4CON, &TMR4, &PR4, 0, &IFS1, 1 << 11, 5},
+    {&T5CON, &TMR5, &PR5, &TMR5HLD, &IFS1, 1 << 12, 0},
+};
+
+typedef struct {
+    unsigned long count;    // counter, 32 bits in 32-bit mode
+    unsigned long frac;     // cycles towards the next count (prescaler)
+    unsigned int seen_lsw;  // register values written by the simulator: a different
+    unsigned int seen_msw;  // value means the firmware has written the counter
+} SimTimer;
+
+SimTimer sim_timers[6];
+
+int sim_timer_paired(int t){
+    const SimTimerRegs* r = &sim_timer_regs[t];
+    return r->slave != 0 && (*r->con & TCON_T32);
+}
+
+// 1 if the timer is the upper half of a 32-bit pair and does not count by itself
+int sim_timer_slaved(int t){
+    return (t == 3 || t == 5) && sim_timer_paired(t - 1);
+}
+
+unsigned long sim_timer_prescale(int t){
+    static const unsigned long div[4] = {1, 8, 64, 256};
+    return div[(*sim_timer_regs[t].con >> 4) & 3];
+}
+
+unsigned long sim_timer_period(int t){
+    const SimTimerRegs* r = &sim_timer_regs[t];
+    if (sim_timer_paired(t)) return ((unsigned long) *sim_timer_regs[r->slave].pr << 16) | *r->pr;
+    return *r->pr;
+}
+
+unsigned long sim_timer_max(int t){
+    return sim_timer_paired(t) ? 0xFFFFFFFFUL : 0xFFFFUL;
+}
+
+// picks up the counter values written by the firmware
+void sim_timer_sync(int t){
+    const SimTimerRegs* r = &sim_timer_regs[t];
+    SimTimer* s = &sim_timers[t];
+
+    if (sim_timer_paired(t)) {
+        const SimTimerRegs* u = &sim_timer_regs[r->slave];
+        unsigned int msw = *u->tmr;
+
+        if (*u->hld != s->seen_msw) msw = *u->hld;
+        if (*r->tmr != s->seen_lsw || msw != s->seen_msw) {
+            s->count = ((unsigned long) msw << 16) | *r->tmr;
+            s->frac = 0;
+        }
+    } else if (*r->tmr != s->seen_lsw) {
+        s->count = *r->tmr;
+        s->frac = 0;
+    }
+}
+
+void sim_timer_publish(int t){
+    const SimTimerRegs* r = &sim_timer_regs[t];
+    SimTimer* s = &sim_timers[t];
+
+    *r->tmr = s->count & 0xFFFF;
+    s->seen_lsw = *r->tmr;
+    if (sim_timer_paired(t)) {
+        const SimTimerRegs* u = &sim_timer_regs[r->slave];
+        *u->tmr = s->count >> 16;
+        *u->hld = s->count >> 16;
+        s->seen_msw = *u->hld;
+    }
+}
+
+// cycles to the next period match, SIM_NEVER if the timer is stopped
+unsigned long long sim_timer_next(int t){
+    SimTimer* s = &sim_timers[t];
+    unsigned long ticks;
+
+    if (!(*sim_timer_regs[t].con & TCON_TON) || sim_timer_slaved(t)) return SIM_NEVER;
+    ticks = ((sim_timer_period(t) - s->count) & sim_timer_max(t)) + 1;
+    return (unsigned long long) ticks * sim_timer_prescale(t) - s->frac;
+}
+
+void sim_timer_advance(int t, unsigned long long cycles){
+    const SimTimerRegs* r = &sim_timer_regs[t];
+    SimTimer* s = &sim_timers[t];
+    const SimTimerRegs* irq = sim_timer_paired(t) ? &sim_timer_regs[r->slave] : r;
+    unsigned long long total, ticks;
+    unsigned long prescale = sim_timer_prescale(t);
+
+    if (!(*r->con & TCON_TON) || sim_timer_slaved(t)) return;
+
+    total = s->frac + cycles;
+    ticks = total / prescale;
+    s->frac = total % prescale;
+    while (ticks > 0) {
+        unsigned long to_match = ((sim_timer_period(t) - s->count) & sim_timer_max(t)) + 1;
+
+        if (ticks < to_match) {
+            s->count = (s->count + ticks) & sim_timer_max(t);
+            break;
+        }
+        ticks -= to_match;
+        s->count = 0;
+        *irq->ifs |= irq->mask;
+        if (t == 1) sim_stats.ticks++;
+    }
+    sim_timer_publish(t);
+}
+
+/* ------------------------------------------------------------------ UART */
+
+#define SIM_UART_FIFO 4
+
+unsigned char sim_tx_fifo[SIM_UART_FIFO];
+int sim_tx_count = 0;
+int sim_tx_shifting = 0;          // 1 while a character is in the shift register
+unsigned char sim_tx_shift;
+unsigned long long sim_tx_done = SIM_NEVER;
+
+int sim_tx_enabled = 0;           // UTXEN seen by the simulator
+
+unsigned char sim_rx_fifo[SIM_UART_FIFO];
+int sim_rx_count = 0;
+unsigned long long sim_rx_next = SIM_NEVER;
+
+// cycles of a character: start, 8 data bits, stop
+unsigned long long sim_uart_char(void){
+    return 10ULL * (U1MODEbits.BRGH ? 4 : 16) * (U1BRG + 1ULL);
+}
+
+void sim_uart_shift(void){
+    sim_tx_shift = sim_tx_fifo[0];
+    memmove(sim_tx_fifo, sim_tx_fifo + 1, --sim_tx_count);
+    sim_tx_shifting = 1;
+    sim_tx_done = sim_now + sim_uart_char();
+    U1STAbits.UTXBF = 0;
+    U1STAbits.TRMT = 0;
+    IFS0bits.U1TXIF = 1; // UTXISEL = 00: a character moved to the shift register
+}
+
+void sim_uart_put(unsigned int c){
+    if (!U1MODEbits.UARTEN || !U1STAbits.UTXEN || sim_tx_count == SIM_UART_FIFO) return;
+
+    sim_tx_fifo[sim_tx_count++] = c;
+    if (!sim_tx_shifting) sim_uart_shift();
+    U1STAbits.UTXBF = (sim_tx_count == SIM_UART_FIFO);
+}
+
+void sim_uart_tx_event(void){
+    if (sim_options.tx) fputc(sim_tx_shift, sim_options.tx);
+    sim_stats.tx_bytes++;
+    sim_tx_shifting = 0;
+    sim_tx_done = SIM_NEVER;
+    if (sim_tx_count > 0) sim_uart_shift();
+    else U1STAbits.TRMT = 1;
+}
+
+unsigned int sim_uart_get(void){
+    unsigned int c;
+
+    if (sim_rx_count == 0) return U1RXREG;
+    c = sim_rx_fifo[0];
+    memmove(sim_rx_fifo, sim_rx_fifo + 1, --sim_rx_count);
+    U1STAbits.URXDA = (sim_rx_count > 0);
+    U1RXREG = c;
+    return c;
+}
+
+// enabling the transmitter flags the empty buffer
+void sim_uart_tx_sync(void){
+    int enabled = U1MODEbits.UARTEN && U1STAbits.UTXEN;
+
+    if (enabled && !sim_tx_enabled) IFS0bits.U1TXIF = 1;
+    sim_tx_enabled = enabled;
+}
+
+// the input is sent at the rate of the UART once the receiver is running
+void sim_uart_rx_schedule(void){
+    if (sim_rx_next != SIM_NEVER || !sim_options.rx) return;
+    if (U1MODEbits.UARTEN && IEC0bits.U1RXIE) sim_rx_next = sim_now + sim_uart_char();
+}
+
+void sim_uart_rx_event(void){
+    int c = fgetc(sim_options.rx);
+
+    sim_rx_next = SIM_NEVER;
+    if (c == EOF) {
+        sim_options.rx = 0;
+        return;
+    }
+    if (sim_rx_count == SIM_UART_FIFO) {
+        U1STAbits.OERR = 1; // the character is lost
+    } else {
+        sim_rx_fifo[sim_rx_count++] = c;
+        U1STAbits.URXDA = 1;
+        sim_stats.rx_bytes++;
+    }
+    sim_uart_rx_schedule();
+}
+
+/* --------------------------------------------------------------- BMX055 */
+
+#define SIM_DEV_ACC 0
+#define SIM_DEV_MAG 1
+#define SIM_DEV_GYR 2
+#define SIM_DEVS 3
+
+typedef struct {
+    volatile unsigned int* cs_lat;
+    unsigned int cs_mask;
+    unsigned char regs[128];
+    int selected; // chip-select low
+    int pos;      // bytes of the current transaction
+    int addr;
+    int read;
+} SimSpiDev;
+
+SimSpiDev sim_devs[SIM_DEVS] = {
+    {&LATB, 1 << 3},
+    {&LATD, 1 << 6},
+    {&LATB, 1 << 4},
+};
+
+unsigned long long sim_mag_next = SIM_NEVER; // end of the running measurement
+int sim_mag_drdy = 0;                        // data ready, cleared by reading the data
+int sim_mag_read = 0;                        // the transaction read the data registers
+unsigned long sim_noise_seed = 12345;
+
+// factory trim: sensitivity 5/16 uT per LSB on every axis, no offsets
+const unsigned char sim_mag_trim[21] = {
+    0, 0, 0, 0, 0, 0,              // 0x5D x1, 0x5E y1, 0x5F-0x62
+    0, 0, 0,                       // 0x63 z4 msb, 0x64 x2, 0x65 y2
+    0, 0,                          // 0x66-0x67
+    6554 & 0xFF, 6554 >> 8,        // 0x68-0x69 z2
+    1, 0,                          // 0x6A-0x6B z1
+    SIM_RHALL & 0xFF, SIM_RHALL >> 8, // 0x6C-0x6D xyz1
+    0, 0,                          // 0x6E-0x6F z3
+    0, 0,                          // 0x70 xy2, 0x71 xy1
+};
+
+double sim_yaw(void){
+    return sim_options.rate * sim_seconds();
+}
+
+// uniform noise in [-noise, noise] LSB
+int sim_noise(void){
+    sim_noise_seed = sim_noise_seed * 1103515245UL + 12345UL;
+    if (sim_options.noise == 0) return 0;
+    return (int) ((sim_noise_seed >> 16) % (2 * sim_options.noise + 1)) - (int) sim_options.noise;
+}
+
+int sim_clamp(double v, int lo, int hi){
+    long r = lround(v);
+    return r < lo ? lo : r > hi ? hi : (int) r;
+}
+
+// DRDY pin on RE8 (INT1 on its rising edge)
+void sim_mag_pin(void){
+    unsigned char ctrl = sim_devs[SIM_DEV_MAG].regs[0x4E];
+    int level = (ctrl & 0x80) ? (sim_mag_drdy ^ !(ctrl & 0x04)) : 0;
+
+    if (level && !PORTEbits.RE8 && RPINR0bits.INT1R == 88 && !INTCON2bits.INT1EP) IFS1bits.INT1IF = 1;
+    PORTEbits.RE8 = level;
+}
+
+// measurement time from the repetitions: 145us * nXY + 500us * nZ + 980us
+unsigned long long sim_mag_meas(void){
+    unsigned char* r = sim_devs[SIM_DEV_MAG].regs;
+    return SIM_US(145UL * (1 + 2UL * r[0x51]) + 500UL * (1 + r[0x52]) + 980);
+}
+
+unsigned long long sim_mag_period(void){
+    static const unsigned int hz[8] = {10, 2, 6, 8, 15, 20, 25, 30};
+    return SIM_FCY / hz[(sim_devs[SIM_DEV_MAG].regs[0x4C] >> 3) & 7];
+}
+
+// the field in the board frame, packed in the data registers 0x42-0x49
+void sim_mag_measure(void){
+    unsigned char* r = sim_devs[SIM_DEV_MAG].regs;
+    double yaw = sim_yaw() * M_PI / 180.0;
+    int x = sim_clamp(SIM_FIELD_H * cos(yaw) / SIM_MAG_LSB + sim_noise(), -4095, 4095);
+    int y = sim_clamp(SIM_FIELD_H * sin(yaw) / SIM_MAG_LSB + sim_noise(), -4095, 4095);
+    int z = sim_clamp(SIM_FIELD_V / SIM_MAG_LSB + sim_noise(), -16383, 16383);
+    unsigned int rhall = (SIM_RHALL << 2) | 1; // bit 0: data ready
+
+    r[0x42] = (x << 3) & 0xF8;
+    r[0x43] = (x >> 5) & 0xFF;
+    r[0x44] = (y << 3) & 0xF8;
+    r[0x45] = (y >> 5) & 0xFF;
+    r[0x46] = (z << 1) & 0xFE;
+    r[0x47] = (z >> 7) & 0xFF;
+    r[0x48] = rhall & 0xFF;
+    r[0x49] = rhall >> 8;
+
+    sim_stats.mag_samples++;
+    sim_mag_drdy = 1;
+    sim_mag_pin();
+}
+
+// opmode in 0x4C[2:1]: 00 normal, 01 forced, 11 sleep
+void sim_mag_mode(void){
+    unsigned char* r = sim_devs[SIM_DEV_MAG].regs;
+    int opmode = (r[0x4C] >> 1) & 3;
+
+    if (!(r[0x4B] & 1) || opmode >= 2) sim_mag_next = SIM_NEVER;
+    else if (opmode == 1) sim_mag_next = sim_now + sim_mag_meas();
+    else sim_mag_next = sim_now + sim_mag_period();
+}
+
+void sim_mag_event(void){
+    unsigned char* r = sim_devs[SIM_DEV_MAG].regs;
+
+    sim_mag_measure();
+    if (((r[0x4C] >> 1) & 3) == 1) {
+        r[0x4C] |= 0x06; // forced mode: back to sleep
+        sim_mag_next = SIM_NEVER;
+    } else {
+        sim_mag_next += sim_mag_period();
+    }
+}
+
+unsigned int sim_dev_read(int dev, int addr){
+    SimSpiDev* d = &sim_devs[dev];
+
+    switch (dev) {
+        case SIM_DEV_MAG:
+            if (addr == 0x40) return (d->regs[0x4B] & 1) ? 0x32 : 0; // chip id, once powered
+            if (addr >= 0x5D && addr <= 0x71) return sim_mag_trim[addr - 0x5D];
+            if (addr >= 0x42 && addr <= 0x49) sim_mag_read = 1;
+            return d->regs[addr];
+        case SIM_DEV_ACC:
+            if (addr == 0x00) return 0xFA;
+            if (addr == 0x07) return (SIM_ACC_1G << 4) >> 8;  // z msb, the board is level
+            if (addr == 0x06) return (SIM_ACC_1G << 4) & 0xF0;
+            if (addr >= 0x02 && addr <= 0x05) return 0;
+            return d->regs[addr];
+        default: {
+            int z = sim_clamp(-sim_options.rate * SIM_GYR_LSB, -32768, 32767); // counter-clockwise positive
+
+            if (addr == 0x00) return 0x0F;
+            if (addr == 0x06) return z & 0xFF;
+            if (addr == 0x07) return (z >> 8) & 0xFF;
+            if (addr >= 0x02 && addr <= 0x05) return 0;
+            return d->regs[addr];
+        }
+    }
+}
+
+void sim_dev_write(int dev, int addr, unsigned int value){
+    SimSpiDev* d = &sim_devs[dev];
+
+    d->regs[addr] = value;
+    if (dev != SIM_DEV_MAG) return;
+    if (addr == 0x4B || addr == 0x4C) sim_mag_mode();
+    if (addr == 0x4E) sim_mag_pin();
+}
+
+// one byte on the bus: the first of a transaction is the address (bit 7 = read)
+unsigned int sim_spi_exchange(unsigned int b){
+    sim_stats.spi_bytes++;
+    for (int i = 0; i < SIM_DEVS; i++) {
+        SimSpiDev* d = &sim_devs[i];
+        unsigned int r = 0xFF;
+
+        if (!d->selected) continue;
+        if (d->pos++ == 0) {
+            d->addr = b & 0x7F;
+            d->read = b & 0x80;
+        } else {
+            if (d->read) r = sim_dev_read(i, d->addr);
+            else sim_dev_write(i, d->addr, b & 0xFF);
+            d->addr = (d->addr + 1) & 0x7F;
+        }
+        return r;
+    }
+    return 0xFF; // nobody selected
+}
+
+void sim_gpio_write(volatile unsigned int* lat, unsigned int value){
+    *lat = value;
+    for (int i = 0; i < SIM_DEVS; i++) {
+        SimSpiDev* d = &sim_devs[i];
+        int selected = !(*d->cs_lat & d->cs_mask);
+
+        if (selected == d->selected) continue;
+        d->selected = selected;
+        d->pos = 0;
+        if (!selected && i == SIM_DEV_MAG && sim_mag_read) {
+            // reading the data clears DRDY
+            sim_mag_read = 0;
+            sim_mag_drdy = 0;
+            d->regs[0x48] &= ~1;
+            sim_stats.mag_reads++;
+            sim_mag_pin();
+        }
+    }
+}
+
+/* ------------------------------------------------------------ SPI and DMA */
+
+unsigned long long sim_spi_done = SIM_NEVER; // end of the byte being shifted
+unsigned long long sim_dma_done = SIM_NEVER; // end of the DMA transfer
+unsigned int sim_spi_rx;
+
+// buffers handed to the DMA: DMAxSTAL holds the index + 1 (pointers do not fit 16 bits)
+#define SIM_DMA_SLOTS 8
+const volatile void* sim_dma_slots[SIM_DMA_SLOTS];
+unsigned int sim_dma_slot = 0;
+
+unsigned long long sim_spi_byte(void){
+    static const unsigned long pri[4] = {64, 16, 4, 1};
+    return 8ULL * pri[SPI1CON1bits.PPRE] * (8 - SPI1CON1bits.SPRE);
+}
+
+void sim_spi_put(unsigned int b){
+    if (!SPI1STATbits.SPIEN) return;
+    SPI1BUF = b;
+    sim_spi_rx = sim_spi_exchange(b);
+    sim_spi_done = sim_now + sim_spi_byte();
+}
+
+unsigned int sim_spi_get(void){
+    SPI1STATbits.SPIRBF = 0;
+    return SPI1BUF;
+}
+
+void sim_spi_event(void){
+    sim_spi_done = SIM_NEVER;
+    if (SPI1STATbits.SPIRBF) SPI1STATbits.SPIROV = 1;
+    SPI1BUF = sim_spi_rx;
+    SPI1STATbits.SPIRBF = 1;
+}
+
+unsigned int sim_dma_addr(const volatile void* p){
+    unsigned int slot = sim_dma_slot++ % SIM_DMA_SLOTS;
+
+    sim_dma_slots[slot] = p;
+    return slot + 1;
+}
+
+// DMA0 shifts the tx buffer out, DMA1 stores what comes back. The bytes are
+// exchanged at once, the end of the transfer is signalled after the bus time
+void sim_dma_force(void){
+    const volatile unsigned char* tx;
+    volatile unsigned char* rx;
+    unsigned int len = DMA0CNT + 1;
+
+    if (!DMA0CONbits.CHEN || DMA0STAL == 0) return;
+    tx = (const volatile unsigned char*) sim_dma_slots[DMA0STAL - 1];
+    rx = (DMA1CONbits.CHEN && DMA1STAL) ? (volatile unsigned char*) sim_dma_slots[DMA1STAL - 1] : 0;
+
+    for (unsigned int i = 0; i < len; i++) {
+        unsigned int r = sim_spi_exchange(tx[i]);
+        if (rx && i <= DMA1CNT) rx[i] = r;
+    }
+    sim_dma_done = sim_now + len * sim_spi_byte();
+}
+
+void sim_dma_event(void){
+    sim_dma_done = SIM_NEVER;
+    DMA0CONbits.CHEN = 0; // one-shot
+    DMA1CONbits.CHEN = 0;
+    IFS0bits.DMA0IF = 1;
+    IFS0bits.DMA1IF = 1;
+}
+
+/* ----------------------------------------------------------------- flash */
+
+#define SIM_FLASH_BASE 0x20000UL
+#define SIM_FLASH_PAGE 2048UL // address units, 1024 instructions
+#define SIM_FLASH_PAGES 4
+
+// low words of the instructions; program memory objects get a page each
+unsigned int sim_flash[SIM_FLASH_PAGES][SIM_FLASH_PAGE / 2];
+const void* sim_flash_objects[SIM_FLASH_PAGES];
+unsigned int sim_latch[2];
+
+unsigned long sim_tbladdress(const void* p){
+    int i;
+
+    for (i = 0; i < SIM_FLASH_PAGES - 1 && sim_flash_objects[i] && sim_flash_objects[i] != p; i++);
+    sim_flash_objects[i] = p;
+    return SIM_FLASH_BASE + i * SIM_FLASH_PAGE;
+}
+
+unsigned int* sim_flash_word(unsigned long addr){
+    static unsigned int unimplemented;
+
+    addr -= SIM_FLASH_BASE;
+    if (addr >= SIM_FLASH_PAGES * SIM_FLASH_PAGE) {
+        unimplemented = 0xFFFF;
+        return &unimplemented;
+    }
+    return &sim_flash[addr / SIM_FLASH_PAGE][(addr % SIM_FLASH_PAGE) / 2];
+}
+
+unsigned int sim_tblrdl(unsigned int offset){
+    return *sim_flash_word(((unsigned long) TBLPAG << 16) | (offset & 0xFFFF));
+}
+
+void sim_tblwtl(unsigned int offset, unsigned int value){
+    sim_latch[(offset >> 1) & 1] = value;
+}
+
+// NVMOP 0x3: page erase, 0x1: double word program; done at once
+void sim_write_nvm(void){
+    unsigned long addr = ((unsigned long) NVMADRU << 16) | NVMADR;
+
+    if ((NVMCON & 0xF) == 0x3) {
+        addr &= ~(SIM_FLASH_PAGE - 1);
+        for (unsigned long a = 0; a < SIM_FLASH_PAGE; a += 2) *sim_flash_word(addr + a) = 0xFFFF;
+    } else if ((NVMCON & 0xF) == 0x1) {
+        *sim_flash_word(addr) &= sim_latch[0];
+        *sim_flash_word(addr + 2) &= sim_latch[1];
+    }
+    NVMCONbits.WR = 0;
+}
+
+void sim_flash_save(void){
+    FILE* f;
+
+    if (!sim_options.flash || !(f = fopen(sim_options.flash, "wb"))) return;
+    fwrite(sim_flash, sizeof(sim_flash), 1, f);
+    fclose(f);
+}
+
+/* ------------------------------------------------------------------ core */
+
+double sim_seconds(void){
+    return (double) sim_now / SIM_FCY;
+}
+
+void sim_init(void){
+    FILE* f;
+
+    for (int p = 0; p < SIM_FLASH_PAGES; p++) {
+        for (unsigned int i = 0; i < SIM_FLASH_PAGE / 2; i++) sim_flash[p][i] = 0xFFFF;
+    }
+    if (sim_options.flash && (f = fopen(sim_options.flash, "rb"))) {
+        if (fread(sim_flash, sizeof(sim_flash), 1, f) != 1) fprintf(stderr, "sim: short flash image\n");
+        fclose(f);
+    }
+    atexit(sim_flash_save);
+
+    // reset values
+    LATB = LATD = LATG = 0xFFFF;
+    TRISA = TRISB = TRISD = TRISE = TRISF = TRISG = 0xFFFF;
+    U1STAbits.TRMT = 1;
+    for (int i = 0; i < SIM_DEVS; i++) sim_devs[i].selected = 0;
+    sim_devs[SIM_DEV_MAG].regs[0x4C] = 0x06; // suspend, sleep mode
+}
+
+// services the pending interrupts if the CPU priority allows it
+void sim_dispatch(void){
+    int again = 1;
+
+    if (sim_in_isr || SRbits.IPL >= SIM_IRQ_LEVEL) return;
+    sim_in_isr = 1;
+    while (again) {
+        again = 0;
+        sim_uart_tx_sync();
+        if (sim_rx_count > 0) IFS0bits.U1RXIF = 1; // URXISEL = 00: while characters are waiting
+        for (unsigned int i = 0; i < SIM_IRQS; i++) {
+            const SimIrq* q = &sim_irqs[i];
+
+            if ((*q->ifs & q->mask) && (*q->iec & q->mask)) {
+                sim_stats.interrupts++;
+                q->handler();
+                again = 1;
+                break;
+            }
+        }
+    }
+    sim_in_isr = 0;
+}
+
+// advances the time to the next event of the simulated hardware and serves it
+void sim_wait(void){
+    unsigned long long next = SIM_NEVER, dt;
+    unsigned long long timer_next[6];
+
+    sim_uart_rx_schedule();
+    for (int t = 1; t <= 5; t++) {
+        sim_timer_sync(t);
+        timer_next[t] = sim_timer_next(t);
+        if (timer_next[t] != SIM_NEVER && sim_now + timer_next[t] < next) next = sim_now + timer_next[t];
+    }
+    if (sim_tx_done < next) next = sim_tx_done;
+    if (sim_rx_next < next) next = sim_rx_next;
+    if (sim_spi_done < next) next = sim_spi_done;
+    if (sim_dma_done < next) next = sim_dma_done;
+    if (sim_mag_next < next) next = sim_mag_next;
+    if (next == SIM_NEVER) {
+        fprintf(stderr, "sim: the firmware waits for an event that never comes\n");
+        exit(1);
+    }
+
+    dt = next - sim_now;
+    sim_now = next;
+    for (int t = 1; t <= 5; t++) sim_timer_advance(t, dt);
+    if (sim_tx_done == sim_now) sim_uart_tx_event();
+    if (sim_rx_next == sim_now) sim_uart_rx_event();
+    if (sim_spi_done == sim_now) sim_spi_event();
+    if (sim_dma_done == sim_now) sim_dma_event();
+    if (sim_mag_next == sim_now) sim_mag_event();
+
+    sim_dispatch();
+    if (sim_options.ticks && sim_stats.ticks >= sim_options.ticks) exit(0);
+}
@@ -0,0 +1,61 @@
+/*
+ * File:   sim.h
+ * Author: group 6
+ *
+ * Simulated dsPIC33EP512MU810 and BMX055 for the host build of the firmware.
+ * The time runs in instruction cycles (Fcy = 72MHz) and advances only while
+ * the firmware waits (Idle or hal_poll()): the code itself takes no time.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+
+#define SIM_FCY 72000000ULL
+
+// options of a run, set by sim_main.c before the firmware starts
+typedef struct {
+    unsigned long ticks;   // TIMER1 periods to run before exiting
+    FILE* rx;              // characters received by UART1, 0 for none
+    FILE* tx;              // characters sent by UART1
+    double rate;           // yaw rate of the simulated board, deg/s
+    unsigned int noise;    // peak noise of the magnetometer samples, LSB
+    const char* flash;     // file keeping the simulated program flash, 0 for none
+} SimOptions;
+
+// counters printed at the end of the run
+typedef struct {
+    unsigned long ticks;       // TIMER1 periods
+    unsigned long mag_samples; // magnetometer measurements
+    unsigned long mag_reads;   // data registers read by the firmware
+    unsigned long spi_bytes;
+    unsigned long tx_bytes;
+    unsigned long rx_bytes;
+    unsigned long interrupts;
+} SimStats;
+
+extern SimOptions sim_options;
+extern SimStats sim_stats;
+
+void sim_init(void);
+void sim_wait(void);
+void sim_dispatch(void);
+double sim_seconds(void);
+
+// register accesses with side effects, see hal.h
+void sim_spi_put(unsigned int b);
+unsigned int sim_spi_get(void);
+unsigned int sim_dma_addr(const volatile void* p);
+void sim_dma_force(void);
+void sim_uart_put(unsigned int c);
+unsigned int sim_uart_get(void);
+void sim_gpio_write(volatile unsigned int* lat, unsigned int value);
+
+// program memory
+unsigned long sim_tbladdress(const void* p);
+unsigned int sim_tblrdl(unsigned int offset);
+void sim_tblwtl(unsigned int offset, unsigned int value);
+void sim_write_nvm(void);
+
+#endif /* SIM_H */
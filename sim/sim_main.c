@@ -0,0 +1,92 @@
+/*
+ * File:   sim_main.c
+ * Author: group 6
+ *
+ * Entry point of the host build: parses the options of the run, starts the
+ * simulated device and the firmware main() (renamed firmware_main by
+ * sim/host.mk). The run ends after the requested number of ticks with a
+ * summary on stderr.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+
+int firmware_main(void);
+
+struct timespec sim_host_start;
+
+double sim_host_seconds(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - sim_host_start.tv_sec) + (now.tv_nsec - sim_host_start.tv_nsec) * 1e-9;
+}
+
+void sim_report(void){
+    double host = sim_host_seconds();
+
+    if (sim_options.tx) fflush(sim_options.tx);
+    fprintf(stderr, "%lu ticks, %.2f s simulated in %.3f s (%.0f ticks/s)\n",
+            sim_stats.ticks, sim_seconds(), host, host > 0 ? sim_stats.ticks / host : 0.0);
+    fprintf(stderr, "magnetometer: %lu samples, %lu read; SPI %lu bytes; UART tx %lu rx %lu bytes; %lu interrupts\n",
+            sim_stats.mag_samples, sim_stats.mag_reads, sim_stats.spi_bytes,
+            sim_stats.tx_bytes, sim_stats.rx_bytes, sim_stats.interrupts);
+}
+
+void sim_usage(const char* name){
+    fprintf(stderr,
+            "usage: %s [-n ticks] [-i rx_file] [-o tx_file] [-r deg_per_s] [-e noise] [-f flash_file]\n"
+            "  -n  10ms ticks to run (default 1000, 0 = forever)\n"
+            "  -i  characters received by the UART ('-' for stdin)\n"
+            "  -o  characters sent by the UART (default stdout, '-' for none)\n"
+            "  -r  yaw rate of the board (default 0)\n"
+            "  -e  peak noise of the magnetometer, LSB (default 2)\n"
+            "  -f  program flash image, loaded and saved (keeps the calibration)\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv){
+    int opt;
+
+    sim_options.tx = stdout;
+    while ((opt = getopt(argc, argv, "n:i:o:r:e:f:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                sim_options.ticks = strtoul(optarg, 0, 10);
+                break;
+            case 'i':
+                sim_options.rx = strcmp(optarg, "-") ? fopen(optarg, "rb") : stdin;
+                if (!sim_options.rx) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'o':
+                sim_options.tx = strcmp(optarg, "-") ? fopen(optarg, "wb") : 0;
+                if (!sim_options.tx && strcmp(optarg, "-")) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                sim_options.rate = atof(optarg);
+                break;
+            case 'e':
+                sim_options.noise = strtoul(optarg, 0, 10);
+                break;
+            case 'f':
+                sim_options.flash = optarg;
+                break;
+            default:
+                sim_usage(argv[0]);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &sim_host_start);
+    atexit(sim_report);
+    sim_init();
+    return firmware_main();
+}
@@ -0,0 +1,216 @@
+/*
+ * File:   xc.h
+ * Author: group 6
+ *
+ * Stand-in for the XC16 device header in the host build: the special function
+ * registers used by the firmware are plain variables (sim/sim.c) with the bit
+ * layout of the dsPIC33EP512MU810, the simulator reads and updates them.
+ */
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include "sim.h"
+
+// a register accessed whole (NAME) or by bit fields (NAMEbits), as with the XC16 headers
+#define SIM_SFR(name) extern volatile union sim_##name##_u { unsigned int w; name##BITS bits; } sim_##name
+#define SIM_BITS16(p) unsigned p##0:1; unsigned p##1:1; unsigned p##2:1; unsigned p##3:1; \
+                      unsigned p##4:1; unsigned p##5:1; unsigned p##6:1; unsigned p##7:1; \
+                      unsigned p##8:1; unsigned p##9:1; unsigned p##10:1; unsigned p##11:1; \
+                      unsigned p##12:1; unsigned p##13:1; unsigned p##14:1; unsigned p##15:1;
+
+// SPI1
+typedef struct {
+    unsigned SPIRBF:1; unsigned SPITBF:1; unsigned SISEL:3; unsigned SRXMPT:1;
+    unsigned SPIROV:1; unsigned SRMPT:1; unsigned SPIBEC:3; unsigned :2;
+    unsigned SPISIDL:1; unsigned :1; unsigned SPIEN:1;
+} SPI1STATBITS;
+typedef struct {
+    unsigned PPRE:2; unsigned SPRE:3; unsigned MSTEN:1; unsigned CKP:1; unsigned SSEN:1;
+    unsigned CKE:1; unsigned SMP:1; unsigned MODE16:1; unsigned DISSDO:1; unsigned DISSCK:1;
+} SPI1CON1BITS;
+SIM_SFR(SPI1STAT);
+SIM_SFR(SPI1CON1);
+#define SPI1STAT sim_SPI1STAT.w
+#define SPI1STATbits sim_SPI1STAT.bits
+#define SPI1CON1 sim_SPI1CON1.w
+#define SPI1CON1bits sim_SPI1CON1.bits
+extern volatile unsigned int SPI1BUF;
+
+// ports
+typedef struct { SIM_BITS16(TRISA) } TRISABITS;
+typedef struct { SIM_BITS16(TRISB) } TRISBBITS;
+typedef struct { SIM_BITS16(TRISD) } TRISDBITS;
+typedef struct { SIM_BITS16(TRISE) } TRISEBITS;
+typedef struct { SIM_BITS16(TRISF) } TRISFBITS;
+typedef struct { SIM_BITS16(TRISG) } TRISGBITS;
+typedef struct { SIM_BITS16(LATB) } LATBBITS;
+typedef struct { SIM_BITS16(LATD) } LATDBITS;
+typedef struct { SIM_BITS16(LATG) } LATGBITS;
+typedef struct { SIM_BITS16(RE) } PORTEBITS;
+SIM_SFR(TRISA);
+SIM_SFR(TRISB);
+SIM_SFR(TRISD);
+SIM_SFR(TRISE);
+SIM_SFR(TRISF);
+SIM_SFR(TRISG);
+SIM_SFR(LATB);
+SIM_SFR(LATD);
+SIM_SFR(LATG);
+SIM_SFR(PORTE);
+#define TRISA sim_TRISA.w
+#define TRISAbits sim_TRISA.bits
+#define TRISB sim_TRISB.w
+#define TRISBbits sim_TRISB.bits
+#define TRISD sim_TRISD.w
+#define TRISDbits sim_TRISD.bits
+#define TRISE sim_TRISE.w
+#define TRISEbits sim_TRISE.bits
+#define TRISF sim_TRISF.w
+#define TRISFbits sim_TRISF.bits
+#define TRISG sim_TRISG.w
+#define TRISGbits sim_TRISG.bits
+#define LATB sim_LATB.w
+#define LATBbits sim_LATB.bits
+#define LATD sim_LATD.w
+#define LATDbits sim_LATD.bits
+#define LATG sim_LATG.w
+#define LATGbits sim_LATG.bits
+#define PORTE sim_PORTE.w
+#define PORTEbits sim_PORTE.bits
+extern volatile unsigned int ANSELA, ANSELB, ANSELC, ANSELD, ANSELE, ANSELG;
+
+// peripheral pin select
+typedef struct { unsigned :8; unsigned INT1R:7; unsigned :1; } RPINR0BITS;
+typedef struct { unsigned U1RXR:7; unsigned :1; unsigned U1CTSR:7; unsigned :1; } RPINR18BITS;
+typedef struct { unsigned SDI1R:7; unsigned :1; unsigned SCK1R:7; unsigned :1; } RPINR20BITS;
+typedef struct { unsigned RP64R:6; unsigned :2; unsigned RP65R:6; unsigned :2; } RPOR0BITS;
+typedef struct { unsigned RP108R:6; unsigned :10; } RPOR11BITS;
+typedef struct { unsigned RP109R:6; unsigned :10; } RPOR12BITS;
+SIM_SFR(RPINR0);
+SIM_SFR(RPINR18);
+SIM_SFR(RPINR20);
+SIM_SFR(RPOR0);
+SIM_SFR(RPOR11);
+SIM_SFR(RPOR12);
+#define RPINR0bits sim_RPINR0.bits
+#define RPINR18bits sim_RPINR18.bits
+#define RPINR20bits sim_RPINR20.bits
+#define RPOR0bits sim_RPOR0.bits
+#define RPOR11bits sim_RPOR11.bits
+#define RPOR12bits sim_RPOR12.bits
+
+// timers: configured through the raw registers, see timer.c
+extern volatile unsigned int T1CON, T2CON, T3CON, T4CON, T5CON;
+extern volatile unsigned int TMR1, TMR2, TMR3, TMR4, TMR5, TMR3HLD, TMR5HLD;
+extern volatile unsigned int PR1, PR2, PR3, PR4, PR5;
+
+// interrupts
+typedef struct {
+    unsigned INT0IF:1; unsigned IC1IF:1; unsigned OC1IF:1; unsigned T1IF:1;
+    unsigned DMA0IF:1; unsigned IC2IF:1; unsigned OC2IF:1; unsigned T2IF:1;
+    unsigned T3IF:1; unsigned SPI1EIF:1; unsigned SPI1IF:1; unsigned U1RXIF:1;
+    unsigned U1TXIF:1; unsigned AD1IF:1; unsigned DMA1IF:1; unsigned NVMIF:1;
+} IFS0BITS;
+typedef struct {
+    unsigned SI2C1IF:1; unsigned MI2C1IF:1; unsigned CMIF:1; unsigned CNIF:1;
+    unsigned INT1IF:1; unsigned AD2IF:1; unsigned IC7IF:1; unsigned IC8IF:1;
+    unsigned DMA2IF:1; unsigned OC3IF:1; unsigned OC4IF:1; unsigned T4IF:1;
+    unsigned T5IF:1; unsigned INT2IF:1; unsigned U2RXIF:1; unsigned U2TXIF:1;
+} IFS1BITS;
+typedef struct {
+    unsigned INT0IE:1; unsigned IC1IE:1; unsigned OC1IE:1; unsigned T1IE:1;
+    unsigned DMA0IE:1; unsigned IC2IE:1; unsigned OC2IE:1; unsigned T2IE:1;
+    unsigned T3IE:1; unsigned SPI1EIE:1; unsigned SPI1IE:1; unsigned U1RXIE:1;
+    unsigned U1TXIE:1; unsigned AD1IE:1; unsigned DMA1IE:1; unsigned NVMIE:1;
+} IEC0BITS;
+typedef struct {
+    unsigned SI2C1IE:1; unsigned MI2C1IE:1; unsigned CMIE:1; unsigned CNIE:1;
+    unsigned INT1IE:1; unsigned AD2IE:1; unsigned IC7IE:1; unsigned IC8IE:1;
+    unsigned DMA2IE:1; unsigned OC3IE:1; unsigned OC4IE:1; unsigned T4IE:1;
+    unsigned T5IE:1; unsigned INT2IE:1; unsigned U2RXIE:1; unsigned U2TXIE:1;
+} IEC1BITS;
+typedef struct {
+    unsigned INT0EP:1; unsigned INT1EP:1; unsigned INT2EP:1; unsigned INT3EP:1;
+    unsigned INT4EP:1; unsigned :8; unsigned SWTRAP:1; unsigned DISI:1; unsigned GIE:1;
+} INTCON2BITS;
+typedef struct { unsigned C:1; unsigned Z:1; unsigned OV:1; unsigned N:1; unsigned RA:1; unsigned IPL:3; unsigned :8; } SRBITS;
+SIM_SFR(IFS0);
+SIM_SFR(IFS1);
+SIM_SFR(IEC0);
+SIM_SFR(IEC1);
+SIM_SFR(INTCON2);
+SIM_SFR(SR);
+#define IFS0 sim_IFS0.w
+#define IFS0bits sim_IFS0.bits
+#define IFS1 sim_IFS1.w
+#define IFS1bits sim_IFS1.bits
+#define IEC0 sim_IEC0.w
+#define IEC0bits sim_IEC0.bits
+#define IEC1 sim_IEC1.w
+#define IEC1bits sim_IEC1.bits
+#define INTCON2bits sim_INTCON2.bits
+#define SRbits sim_SR.bits
+
+// UART1
+typedef struct {
+    unsigned STSEL:1; unsigned PDSEL:2; unsigned BRGH:1; unsigned URXINV:1; unsigned ABAUD:1;
+    unsigned LPBACK:1; unsigned WAKE:1; unsigned UEN:2; unsigned :1; unsigned RTSMD:1;
+    unsigned IREN:1; unsigned USIDL:1; unsigned :1; unsigned UARTEN:1;
+} U1MODEBITS;
+typedef struct {
+    unsigned URXDA:1; unsigned OERR:1; unsigned FERR:1; unsigned PERR:1; unsigned RIDLE:1;
+    unsigned ADDEN:1; unsigned URXISEL:2; unsigned TRMT:1; unsigned UTXBF:1; unsigned UTXEN:1;
+    unsigned UTXBRK:1; unsigned :1; unsigned UTXISEL0:1; unsigned UTXINV:1; unsigned UTXISEL1:1;
+} U1STABITS;
+SIM_SFR(U1MODE);
+SIM_SFR(U1STA);
+#define U1MODEbits sim_U1MODE.bits
+#define U1STAbits sim_U1STA.bits
+extern volatile unsigned int U1BRG, U1TXREG, U1RXREG;
+
+// DMA
+typedef struct {
+    unsigned MODE:2; unsigned :2; unsigned AMODE:2; unsigned :5; unsigned NULLW:1;
+    unsigned HALF:1; unsigned DIR:1; unsigned SIZE:1; unsigned CHEN:1;
+} DMA0CONBITS;
+typedef DMA0CONBITS DMA1CONBITS;
+typedef struct { unsigned IRQSEL:8; unsigned :7; unsigned FORCE:1; } DMA0REQBITS;
+typedef DMA0REQBITS DMA1REQBITS;
+SIM_SFR(DMA0CON);
+SIM_SFR(DMA1CON);
+SIM_SFR(DMA0REQ);
+SIM_SFR(DMA1REQ);
+#define DMA0CONbits sim_DMA0CON.bits
+#define DMA1CONbits sim_DMA1CON.bits
+#define DMA0REQbits sim_DMA0REQ.bits
+#define DMA1REQbits sim_DMA1REQ.bits
+extern volatile unsigned int DMA0STAL, DMA0STAH, DMA0PAD, DMA0CNT;
+extern volatile unsigned int DMA1STAL, DMA1STAH, DMA1PAD, DMA1CNT;
+
+// flash programming
+typedef struct { unsigned NVMOP:4; unsigned :8; unsigned NVMSIDL:1; unsigned WRERR:1; unsigned WREN:1; unsigned WR:1; } NVMCONBITS;
+SIM_SFR(NVMCON);
+#define NVMCON sim_NVMCON.w
+#define NVMCONbits sim_NVMCON.bits
+extern volatile unsigned int NVMADR, NVMADRU, TBLPAG;
+
+// CPU
+#define Idle() sim_wait()
+#define Nop() ((void) 0)
+#define SET_AND_SAVE_CPU_IPL(save, ipl) do { (save) = SRbits.IPL; SRbits.IPL = (ipl); } while (0)
+#define SET_CPU_IPL(ipl) do { SRbits.IPL = (ipl); sim_dispatch(); } while (0)
+#define RESTORE_CPU_IPL(save) SET_CPU_IPL(save)
+
+// compiler extensions: the interrupt attributes are dropped (the simulator calls the
+// handlers), program memory is emulated by sim.c
+#define __interrupt__ __used__
+#define __auto_psv__ __used__
+#define __prog__
+#define __builtin_tbladdress(p) sim_tbladdress((const void*) (p))
+#define __builtin_tblrdl(offset) sim_tblrdl(offset)
+#define __builtin_tblwtl(offset, value) sim_tblwtl((offset), (value))
+#define __builtin_tblwth(offset, value) ((void) (offset), (void) (value))
+#define __builtin_write_NVM() sim_write_nvm()
+
+#endif /* SIM_XC_H */
@@ -8,127 +8,286 @@
 #include "xc.h"
 #include "spi.h"
 
-void spi_init() {
-    SPI1STATbits.SPIEN = 0;    // Disable SPI to configure it
+// commands shifted out by DMA0 to burst-read the data registers of the sensors.
+// Not const: const data is placed in program memory (read through PSV),
+// which the DMA cannot read
+unsigned char mag_read_cmd[MAG_DATA_LEN + 1] = {MAG_DATA_ADDR | 0x80};
+unsigned char acc_read_cmd[ACC_DATA_LEN + 1] = {ACC_DATA_ADDR | 0x80};
+unsigned char gyr_read_cmd[GYR_DATA_LEN + 1] = {GYR_DATA_ADDR | 0x80};
 
-    SPI1CON1bits.MSTEN = 1;    // Master mode
-    SPI1CON1bits.MODE16 = 0;   // 8-bit mode
-    SPI1CON1bits.CKE = 1;      // Data changes on transition from idle to active clock state
-    SPI1STATbits.SPIROV = 0;   // Clear overflow
+// read started by the DRDY interrupt
+SpiTransfer mag_xfer;
+unsigned char mag_rx[MAG_DATA_LEN + 1]; // address echo + data registers
+unsigned long mag_drdy_stamp;           // clock at the last DRDY edge
 
-    // Fcy = 72MHz, F_SPI = Fcy / (Primary * Secondary)
-    SPI1CON1bits.PPRE = 0b00;  // Primary prescaler 64:1
-    SPI1CON1bits.SPRE = 0b101; // Secondary prescaler 3:1
-    
-    // Remapping configuration
-    TRISAbits.TRISA1 = 1; // RA1-RPI17 MISO
-    TRISFbits.TRISF12 = 0; // RF12-RP108 SCK
-    TRISFbits.TRISF13 = 0; // RF13-RP109 MOSI
-    
-    // configure CS pins
-    TRISBbits.TRISB3 = 0;
-    TRISBbits.TRISB4 = 0;
-    TRISDbits.TRISD6 = 0;
-    
-    RPINR20bits.SDI1R = 0b0010001; // MISO (SDI1) - RPI17
-    RPOR12bits.RP109R = 0b000101; // MOSI (SDO1) - RF13;
-    RPOR11bits.RP108R = 0b000110; // SCK1; 
-    
-    ACC_CS = 1;
-    GYR_CS = 1;
-    MAG_CS = 1;
+// data rates accepted by $ODR. The repetitions follow the Bosch presets:
+// high accuracy (47/83) up to 20Hz, enhanced (15/27), regular (9/15), low power (3/3);
+// the measurement time (145us*nXY + 500us*nZ + 980us) must fit in the period
+const MagOdrPreset mag_odr_presets[] = {
+    {2,   0b001, 0, 23, 82},
+    {6,   0b010, 0, 23, 82},
+    {8,   0b011, 0, 23, 82},
+    {10,  0b000, 0, 23, 82},
+    {15,  0b100, 0, 7, 26},
+    {20,  0b101, 0, 23, 82},
+    {25,  0b110, 0, 7, 26},
+    {30,  0b111, 0, 7, 26},
+    {50,  0b000, 1, 4, 14},
+    {100, 0b000, 1, 1, 2},
+};
+#define MAG_ODR_PRESETS (sizeof(mag_odr_presets) / sizeof(mag_odr_presets[0]))
 
-    SPI1STATbits.SPIEN = 1;    // enable SPI
-}
+// write of 0x4C that starts a forced-mode measurement
+unsigned char mag_trigger_cmd[2] = {0x4C, 0b010};
+unsigned char mag_trigger_rx[2];
+SpiTransfer mag_trigger_xfer = {SPI_DEV_MAG, mag_trigger_cmd, mag_trigger_rx, 2, 1, 0, SPI_PRIO_LOW};
 
+// samples read by the DMA, consumed by mag_pop() (free-running indexes)
+MagReading mag_queue[MAG_QUEUE_SIZE];
+volatile unsigned int mag_queue_head = 0;
+volatile unsigned int mag_queue_tail = 0;
+volatile unsigned int mag_dropped = 0; // samples lost because the queue was full or the bus busy
+
+// reads one magnetometer register (blocking)
 unsigned int spi_write(unsigned int read_addr){
-    unsigned int value;
-    unsigned int trash;
-    
-    MAG_CS = 0;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = read_addr | 0x80;
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = 0x00;
-    while (SPI1STATbits.SPIRBF == 0);
-    value = SPI1BUF;
-    MAG_CS = 1;
+    return spi_read_reg(SPI_DEV_MAG, read_addr);
+}
+
+// reads two consecutive magnetometer registers (blocking)
+void spi_write_2_reg(unsigned int read_addr, unsigned int* value1, unsigned int* value2){
+    unsigned char tx[3] = {read_addr | 0xC0, 0x00, 0x00};
+    unsigned char rx[3];
+
+    spi_transfer(SPI_DEV_MAG, tx, rx, 3);
+    *value1 = rx[1];
+    *value2 = rx[2];
+}
+
+// reads len (up to SPI_SYNC_MAX - 1) consecutive magnetometer registers starting
+// from start_addr in a single CS-low transaction (the sensor auto-increments the address)
+void spi_read_burst(unsigned int start_addr, unsigned char* data, int len){
+    unsigned char tx[SPI_SYNC_MAX] = {start_addr | 0x80};
+    unsigned char rx[SPI_SYNC_MAX];
+
+    spi_transfer(SPI_DEV_MAG, tx, rx, len + 1);
+    for (int i = 0; i < len; i++) data[i] = rx[i + 1];
+}
+
+void mag_enable(){
+    mag_write_reg(0x4B, 0x01); // sleep mode
     
-    if (SPI1STATbits.SPIROV == 1){
-        SPI1STATbits.SPIROV = 0;
-    }
+    tmr_wait_ms(TIMER3, 4); // wait 4ms for the magnetometer to switch to sleep mode 
     
-    return value;
+    mag_write_reg(0x4C, 0b00110000); // active mode, 25hz
 }
 
-void spi_write_2_reg(unsigned int read_addr, unsigned int* value1, unsigned int* value2){
-    unsigned int trash;
+// reads X, Y, Z and RHALL with one burst so that the sample is coherent
+void mag_read_sample(MagSample* sample){
+    unsigned char data[MAG_DATA_LEN];
 
-    MAG_CS = 0;
+    spi_read_burst(MAG_DATA_ADDR, data, MAG_DATA_LEN);
+    mag_unpack_sample(data, sample);
+}
 
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = read_addr | 0xC0;
+// reads the factory trim registers (blocking), to be done once at startup
+void mag_read_trim(MagTrim* trim){
+    unsigned char data[MAG_TRIM_LEN];
 
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF; 
+    spi_read_burst(MAG_TRIM_ADDR, data, MAG_TRIM_LEN);
+    magcomp_unpack_trim(data, trim);
+}
 
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = 0x00;
+// converts the raw 0x42-0x49 registers into a sample.
+// X and Y are 13 bits in [15:3], Z is 15 bits in [15:1], RHALL is 14 bits in [15:2];
+// the arithmetic right shift of the signed 16-bit word does the sign-extension
+void mag_unpack_sample(const unsigned char* data, MagSample* sample){
+    sample->x = (short) (((unsigned int) data[1] << 8) | (data[0] & 0xF8)) >> 3;
+    sample->y = (short) (((unsigned int) data[3] << 8) | (data[2] & 0xF8)) >> 3;
+    sample->z = (short) (((unsigned int) data[5] << 8) | (data[4] & 0xFE)) >> 1;
+    sample->rhall = (((unsigned int) data[7] << 8) | (data[6] & 0xFC)) >> 2;
+}
 
-    while (SPI1STATbits.SPIRBF == 0);
-    *value1 = SPI1BUF;
+// fills a descriptor that burst-reads the magnetometer data registers.
+// rx must hold MAG_DATA_LEN + 1 bytes, the data start at rx[1]
+void mag_prepare_read(SpiTransfer* xfer, unsigned char* rx){
+    xfer->dev = SPI_DEV_MAG;
+    xfer->tx = mag_read_cmd;
+    xfer->rx = rx;
+    xfer->len = MAG_DATA_LEN + 1;
+    xfer->done = 0;
+    xfer->callback = 0;
+    xfer->priority = SPI_PRIO_MAG;
+}
+// writes one register of a device (blocking)
+void spi_write_reg(int dev, unsigned int addr, unsigned int value){
+    unsigned char tx[2] = {addr & 0x7F, value};
+    unsigned char rx[2];
 
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = 0x00;
+    spi_transfer(dev, tx, rx, 2);
+}
 
-    while (SPI1STATbits.SPIRBF == 0);
-    *value2 = SPI1BUF;
+// reads one register of a device (blocking)
+unsigned int spi_read_reg(int dev, unsigned int addr){
+    unsigned char tx[2] = {addr | 0x80, 0x00};
+    unsigned char rx[2];
 
-    MAG_CS = 1;
+    spi_transfer(dev, tx, rx, 2);
+    return rx[1];
+}
 
-    //clear overflow
-    if (SPI1STATbits.SPIROV == 1){
-        SPI1STATbits.SPIROV = 0;
+// writes one magnetometer register (blocking)
+void mag_write_reg(unsigned int addr, unsigned int value){
+    spi_write_reg(SPI_DEV_MAG, addr, value);
+}
+
+// end of the read started by DRDY: queue the sample with its timestamp
+void mag_read_done(SpiTransfer* xfer){
+    if (mag_queue_head - mag_queue_tail == MAG_QUEUE_SIZE) {
+        mag_dropped++;
+        return;
     }
+
+    MagReading* r = &mag_queue[mag_queue_head & (MAG_QUEUE_SIZE - 1)];
+    mag_unpack_sample(&xfer->rx[1], &r->sample);
+    r->stamp = mag_drdy_stamp;
+    mag_queue_head++;
 }
 
-void mag_enable(){
-    unsigned int addr;
-    unsigned int trash;
-    
-    // sleep mode
-    MAG_CS = 0;
-    addr = 0x004B;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = addr & 0x7F;
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = 0x01;
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF;
-    MAG_CS = 1;
-    
-    tmr_wait_ms(TIMER3, 4); // wait 4ms for the magnetometer to switch to sleep mode 
-    
-    // active mode
-    MAG_CS = 0;
-    addr = 0x004C;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = addr & 0x7F;
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF;
-    while (SPI1STATbits.SPITBF == 1);
-    SPI1BUF = 0b00110000; //25hz
-    //SPI1BUF = 0x00; // default 10Hz
-    while (SPI1STATbits.SPIRBF == 0);
-    trash = SPI1BUF;
-    MAG_CS = 1;
-    
-    //clear overflow
-    if (SPI1STATbits.SPIROV == 1){
-        SPI1STATbits.SPIROV = 0;
+// enables the DRDY pin of the magnetometer and the INT1 interrupt on its rising edge.
+// Must be called after spi_dma_init() and once the clock is running (tmr_start_clock()).
+void mag_drdy_init(){
+    mag_prepare_read(&mag_xfer, mag_rx);
+    mag_xfer.callback = mag_read_done;
+    mag_xfer.done = 1;
+
+    // 0x4E: DRDY pin enabled, X/Y/Z enabled, DRDY active high
+    mag_write_reg(0x4E, 0x84);
+
+    TRISEbits.TRISE8 = 1;
+    RPINR0bits.INT1R = MAG_DRDY_RPI;
+    INTCON2bits.INT1EP = 0; // rising edge
+    IFS1bits.INT1IF = 0;
+    IEC1bits.INT1IE = 1;
+
+    // DRDY is cleared by reading the data: if a sample is already waiting
+    // there will be no edge, so read it now
+    if (MAG_DRDY) IFS1bits.INT1IF = 1;
+}
+
+// takes the oldest sample read from the magnetometer.
+// Returns 1 if a sample was available, 0 otherwise
+int mag_pop(MagReading* reading){
+    if (mag_queue_head == mag_queue_tail) return 0;
+
+    *reading = mag_queue[mag_queue_tail & (MAG_QUEUE_SIZE - 1)];
+    mag_queue_tail++;
+    return 1;
+}
+
+// Interrupt INT1: new magnetometer data, timestamp it and start the read
+void __attribute__((__interrupt__, __auto_psv__)) _INT1Interrupt() {
+    IFS1bits.INT1IF = 0; // Reset flag interrupt
+
+    if (!mag_xfer.done) { // previous read still in flight
+        mag_dropped++;
+        return;
     }
-}
\ No newline at end of file
+
+    mag_drdy_stamp = tmr_clock();
+    if (!spi_submit(&mag_xfer)) mag_dropped++; // bus queue full, done is still set
+}
+
+// Returns the preset for the given data rate, 0 if the rate is not supported
+const MagOdrPreset* mag_find_odr(unsigned int hz){
+    for (unsigned int i = 0; i < MAG_ODR_PRESETS; i++) {
+        if (mag_odr_presets[i].hz == hz) return &mag_odr_presets[i];
+    }
+    return 0;
+}
+
+// reprograms data rate and repetitions. The acquisition is suspended
+// while the registers are written with the blocking functions
+void mag_set_odr(const MagOdrPreset* preset){
+    IEC1bits.INT1IE = 0;
+    while (!mag_trigger_xfer.done) hal_poll(); // mag_trigger_cmd is about to change
+
+    mag_write_reg(0x4C, 0b110); // sleep mode while changing the repetitions
+    mag_write_reg(0x51, preset->rep_xy);
+    mag_write_reg(0x52, preset->rep_z);
+    // normal mode at the preset rate; in forced mode stay in sleep until mag_trigger()
+    mag_trigger_cmd[1] = (preset->odr << 3) | 0b010;
+    mag_write_reg(0x4C, preset->forced ? ((preset->odr << 3) | 0b110) : (preset->odr << 3));
+
+    IFS1bits.INT1IF = MAG_DRDY; // read a sample already waiting
+    IEC1bits.INT1IE = 1;
+}
+
+// starts a forced-mode measurement, the sample is read on DRDY as in normal mode
+void mag_trigger(){
+    if (!mag_trigger_xfer.done) return; // previous trigger still queued
+    spi_submit(&mag_trigger_xfer); // if the queue is full done stays set, retried at the next period
+}
+
+// resets the accelerometer and sets +-2g, 62.5Hz bandwidth (125Hz data rate), normal mode.
+// Blocking. Returns 0 if the accelerometer is not found
+int acc_enable(){
+    if (spi_read_reg(SPI_DEV_ACC, ACC_CHIP_ID_ADDR) != ACC_CHIP_ID) return 0;
+
+    spi_write_reg(SPI_DEV_ACC, 0x14, 0xB6); // soft reset
+    tmr_wait_ms(TIMER3, 2);                 // start-up time after the reset
+    spi_write_reg(SPI_DEV_ACC, 0x0F, 0x03); // range +-2g
+    spi_write_reg(SPI_DEV_ACC, 0x10, 0x0B); // bandwidth 62.5Hz
+    spi_write_reg(SPI_DEV_ACC, 0x11, 0x00); // normal mode
+    return 1;
+}
+
+// fills a descriptor that burst-reads the accelerometer data registers.
+// rx must hold ACC_DATA_LEN + 1 bytes, the data start at rx[1]
+void acc_prepare_read(SpiTransfer* xfer, unsigned char* rx){
+    xfer->dev = SPI_DEV_ACC;
+    xfer->tx = acc_read_cmd;
+    xfer->rx = rx;
+    xfer->len = ACC_DATA_LEN + 1;
+    xfer->done = 1;
+    xfer->callback = 0;
+    xfer->priority = SPI_PRIO_ACC;
+}
+
+// converts the raw 0x02-0x07 registers into a sample: 12 bits in [15:4]
+void acc_unpack_sample(const unsigned char* data, AccSample* sample){
+    sample->x = (short) (((unsigned int) data[1] << 8) | (data[0] & 0xF0)) >> 4;
+    sample->y = (short) (((unsigned int) data[3] << 8) | (data[2] & 0xF0)) >> 4;
+    sample->z = (short) (((unsigned int) data[5] << 8) | (data[4] & 0xF0)) >> 4;
+}
+
+// resets the gyroscope and sets +-250 deg/s, 100Hz data rate (32Hz filter), normal mode.
+// Blocking. Returns 0 if the gyroscope is not found
+int gyr_enable(){
+    if (spi_read_reg(SPI_DEV_GYR, GYR_CHIP_ID_ADDR) != GYR_CHIP_ID) return 0;
+
+    spi_write_reg(SPI_DEV_GYR, 0x14, 0xB6); // soft reset
+    tmr_wait_ms(TIMER3, 30);                // start-up time after the reset
+    spi_write_reg(SPI_DEV_GYR, 0x0F, 0x03); // range +-250 deg/s
+    spi_write_reg(SPI_DEV_GYR, 0x10, 0x07); // 100Hz, 32Hz bandwidth
+    spi_write_reg(SPI_DEV_GYR, 0x11, 0x00); // normal mode
+    return 1;
+}
+
+// fills a descriptor that burst-reads the gyroscope data registers.
+// rx must hold GYR_DATA_LEN + 1 bytes, the data start at rx[1]
+void gyr_prepare_read(SpiTransfer* xfer, unsigned char* rx){
+    xfer->dev = SPI_DEV_GYR;
+    xfer->tx = gyr_read_cmd;
+    xfer->rx = rx;
+    xfer->len = GYR_DATA_LEN + 1;
+    xfer->done = 1;
+    xfer->callback = 0;
+    xfer->priority = SPI_PRIO_GYR;
+}
+
+// converts the raw 0x02-0x07 registers into a sample
+void gyr_unpack_sample(const unsigned char* data, GyrSample* sample){
+    sample->x = (short) (((unsigned int) data[1] << 8) | data[0]);
+    sample->y = (short) (((unsigned int) data[3] << 8) | data[2]);
+    sample->z = (short) (((unsigned int) data[5] << 8) | data[4]);
+}
@@ -33,14 +33,97 @@
 
 #include <xc.h> // include processor files - each processor file is guarded.
 #include "timer.h"
-#define ACC_CS LATBbits.LATB3
-#define MAG_CS LATDbits.LATD6
-#define GYR_CS LATBbits.LATB4
+#include "magcomp.h"
+#include "spibus.h"
+
+// magnetometer data registers: X, Y, Z and RHALL, LSB first (0x42-0x49)
+#define MAG_DATA_ADDR 0x42
+#define MAG_DATA_LEN 8
+
+// magnetometer DRDY pin: RE8 - RPI88, mapped on INT1
+#define MAG_DRDY_RPI 88
+#define MAG_DRDY PORTEbits.RE8
+#define MAG_QUEUE_SIZE 4 // samples waiting for the main loop, power of two
+
+// data rate preset: ODR bits of 0x4C and repetitions (0x51: nXY = 1 + 2*rep_xy, 0x52: nZ = 1 + rep_z).
+// Rates above 30Hz are not available in normal mode: the sensor is triggered
+// in forced mode by mag_trigger(), called at that rate
+typedef struct {
+    unsigned int hz;
+    unsigned char odr;
+    unsigned char forced;
+    unsigned char rep_xy;
+    unsigned char rep_z;
+} MagOdrPreset;
+
+// one magnetometer sample, already sign-extended
+typedef struct {
+    int x;              // 13-bit signed
+    int y;              // 13-bit signed
+    int z;              // 15-bit signed
+    unsigned int rhall; // 14-bit unsigned
+} MagSample;
+
+// sample with the free-running clock at the rising edge of DRDY (see tmr_clock())
+typedef struct {
+    MagSample sample;
+    unsigned long stamp;
+} MagReading;
+
+// accelerometer (BMA2x2) registers: chip id, X, Y, Z LSB first (0x02-0x07)
+#define ACC_CHIP_ID_ADDR 0x00
+#define ACC_CHIP_ID 0xFA
+#define ACC_DATA_ADDR 0x02
+#define ACC_DATA_LEN 6
+#define ACC_LSB_PER_G 1024 // +-2g range, 12 bits
+
+// one accelerometer sample, 12-bit signed
+typedef struct {
+    int x;
+    int y;
+    int z;
+} AccSample;
+
+// gyroscope (BMG160) registers: chip id, rate X, Y, Z LSB first (0x02-0x07)
+#define GYR_CHIP_ID_ADDR 0x00
+#define GYR_CHIP_ID 0x0F
+#define GYR_DATA_ADDR 0x02
+#define GYR_DATA_LEN 6
+
+// one gyroscope sample, 16-bit signed, 131.2 LSB per deg/s (+-250 deg/s)
+typedef struct {
+    int x;
+    int y;
+    int z;
+} GyrSample;
 
-void spi_init();
 unsigned int spi_write(unsigned int data);
 void spi_write_2_reg(unsigned int read_addr, unsigned int* value1, unsigned int* value2);
+void spi_read_burst(unsigned int start_addr, unsigned char* data, int len);
 void mag_enable();
+void mag_read_sample(MagSample* sample);
+void mag_read_trim(MagTrim* trim);
+void mag_unpack_sample(const unsigned char* data, MagSample* sample);
+
+void mag_prepare_read(SpiTransfer* xfer, unsigned char* rx);
+
+void spi_write_reg(int dev, unsigned int addr, unsigned int value);
+unsigned int spi_read_reg(int dev, unsigned int addr);
+void mag_write_reg(unsigned int addr, unsigned int value);
+void mag_drdy_init();
+int mag_pop(MagReading* reading);
+const MagOdrPreset* mag_find_odr(unsigned int hz);
+void mag_set_odr(const MagOdrPreset* preset);
+void mag_trigger();
+extern volatile unsigned int mag_dropped;
+
+int acc_enable();
+void acc_prepare_read(SpiTransfer* xfer, unsigned char* rx);
+void acc_unpack_sample(const unsigned char* data, AccSample* sample);
+
+int gyr_enable();
+void gyr_prepare_read(SpiTransfer* xfer, unsigned char* rx);
+void gyr_unpack_sample(const unsigned char* data, GyrSample* sample);
 
 #ifdef	__cplusplus
 extern "C" {
@@ -0,0 +1,210 @@
+/*
+ * File:   spibus.c
+ * Author: group 6
+ *
+ * SPI1 bus manager: every device has a descriptor with its chip-select and
+ * bus settings, transfers are queued by priority and shifted by DMA,
+ * the next one starting from the interrupt that ends the previous.
+ */
+
+#include "spibus.h"
+
+// Fcy = 72MHz, F_SPI = 72MHz / (64 * 3) = 375kHz, mode 0 (CKP = 0, CKE = 1)
+const SpiDevice spi_devices[SPI_NUM_DEVS] = {
+    {&LATB, 1 << 3, SPI_CON1(0, 1, 0b00, 0b101)}, // SPI_DEV_ACC
+    {&LATD, 1 << 6, SPI_CON1(0, 1, 0b00, 0b101)}, // SPI_DEV_MAG
+    {&LATB, 1 << 4, SPI_CON1(0, 1, 0b00, 0b101)}, // SPI_DEV_GYR
+};
+
+// transfer on the bus, 0 if idle
+SpiTransfer* spi_active = 0;
+// transfers waiting for the bus, sorted by priority
+SpiTransfer* spi_queue[SPI_QUEUE_SIZE];
+int spi_queue_count = 0;
+// SPI1CON1 currently loaded
+unsigned int spi_con1 = 0;
+// 1 once spi_dma_init() has been called
+int spi_dma_ready = 0;
+
+// loads the settings of the device, if different from the current ones
+void spi_configure(int dev){
+    unsigned int con1 = spi_devices[dev].con1;
+
+    if (con1 == spi_con1) return;
+    SPI1STATbits.SPIEN = 0;    // Disable SPI to configure it
+    SPI1CON1 = con1;
+    SPI1STATbits.SPIEN = 1;
+    spi_con1 = con1;
+}
+
+void spi_init() {
+    SPI1STATbits.SPIEN = 0;    // Disable SPI to configure it
+    SPI1STATbits.SPIROV = 0;   // Clear overflow
+    
+    // Remapping configuration
+    TRISAbits.TRISA1 = 1; // RA1-RPI17 MISO
+    TRISFbits.TRISF12 = 0; // RF12-RP108 SCK
+    TRISFbits.TRISF13 = 0; // RF13-RP109 MOSI
+    
+    // configure CS pins
+    TRISBbits.TRISB3 = 0;
+    TRISBbits.TRISB4 = 0;
+    TRISDbits.TRISD6 = 0;
+    
+    RPINR20bits.SDI1R = 0b0010001; // MISO (SDI1) - RPI17
+    RPOR12bits.RP109R = 0b000101; // MOSI (SDO1) - RF13;
+    RPOR11bits.RP108R = 0b000110; // SCK1; 
+    
+    ACC_CS = 1;
+    GYR_CS = 1;
+    MAG_CS = 1;
+
+    spi_con1 = 0;
+    spi_configure(SPI_DEV_MAG); // enables SPI
+}
+
+// drives the chip-select of the given device
+void spi_set_cs(int dev, int level){
+    const SpiDevice* d = &spi_devices[dev];
+
+    if (level) hal_gpio_set(d->cs_lat, d->cs_mask);
+    else hal_gpio_clear(d->cs_lat, d->cs_mask);
+}
+
+// configures DMA0 (RAM -> SPI1BUF) and DMA1 (SPI1BUF -> RAM).
+// Both channels are triggered by the SPI1 transfer done event, the end of
+// the transfer is signalled by the DMA1 interrupt.
+// From now on the blocking transfers go through the queue too
+void spi_dma_init(){
+    DMA0CONbits.SIZE = 1;      // byte transfers
+    DMA0CONbits.DIR = 1;       // RAM to peripheral
+    DMA0CONbits.AMODE = 0;     // register indirect with post-increment
+    DMA0CONbits.MODE = 1;      // one-shot, ping-pong disabled
+    DMA0REQbits.IRQSEL = 0x0A; // SPI1 transfer done
+    DMA0PAD = hal_dma_addr(&SPI1BUF);
+
+    DMA1CONbits.SIZE = 1;      // byte transfers
+    DMA1CONbits.DIR = 0;       // peripheral to RAM
+    DMA1CONbits.AMODE = 0;     // register indirect with post-increment
+    DMA1CONbits.MODE = 1;      // one-shot, ping-pong disabled
+    DMA1REQbits.IRQSEL = 0x0A; // SPI1 transfer done
+    DMA1PAD = hal_dma_addr(&SPI1BUF);
+
+    IFS0bits.DMA1IF = 0;
+    IEC0bits.DMA1IE = 1; // enable DMA1 interrupt (end of transfer)
+    spi_dma_ready = 1;
+}
+
+// selects the device and lets the DMA shift the whole transfer
+void spi_start(SpiTransfer* xfer){
+    spi_active = xfer;
+    spi_configure(xfer->dev);
+    spi_set_cs(xfer->dev, 0);
+
+    DMA0STAL = hal_dma_addr(xfer->tx);
+    DMA0STAH = 0;
+    DMA0CNT = xfer->len - 1;
+
+    DMA1STAL = hal_dma_addr(xfer->rx);
+    DMA1STAH = 0;
+    DMA1CNT = xfer->len - 1;
+
+    DMA1CONbits.CHEN = 1; // arm the receiver first
+    DMA0CONbits.CHEN = 1;
+    hal_dma_force(); // send the first byte, the others follow the transfer done events
+}
+
+// queues an asynchronous transfer and returns immediately.
+// Returns 1 if the transfer has been queued, 0 if the queue is full:
+// done is cleared only when the transfer is queued, so a rejected one can be retried.
+// Called from the main loop and from INT1: the CPU priority is raised to mask
+// both DMA1 and INT1 while the bus state is updated
+int spi_submit(SpiTransfer* xfer){
+    int queued = 0;
+    int ipl;
+    int i;
+
+    SET_AND_SAVE_CPU_IPL(ipl, SPI_IPL);
+    if (spi_active == 0) {
+        // bus idle: start right away
+        xfer->done = 0;
+        spi_start(xfer);
+        queued = 1;
+    } else if (spi_queue_count < SPI_QUEUE_SIZE) {
+        xfer->done = 0;
+        // insert after the transfers with the same or a higher priority
+        for (i = spi_queue_count; i > 0 && spi_queue[i - 1]->priority > xfer->priority; i--) {
+            spi_queue[i] = spi_queue[i - 1];
+        }
+        spi_queue[i] = xfer;
+        spi_queue_count++;
+        queued = 1;
+    }
+    RESTORE_CPU_IPL(ipl);
+
+    return queued;
+}
+
+// Interrupt DMA1: the transfer on the bus is complete
+void __attribute__((__interrupt__, __auto_psv__)) _DMA1Interrupt() {
+    IFS0bits.DMA1IF = 0; // Reset flag interrupt
+
+    SpiTransfer* xfer = spi_active;
+    spi_set_cs(xfer->dev, 1);
+
+    //clear overflow
+    if (SPI1STATbits.SPIROV == 1){
+        SPI1STATbits.SPIROV = 0;
+    }
+
+    // chain the next queued transfer before the callback, so the bus does not wait for it
+    if (spi_queue_count > 0) {
+        spi_start(spi_queue[0]);
+        spi_queue_count--;
+        for (int i = 0; i < spi_queue_count; i++) spi_queue[i] = spi_queue[i + 1];
+    } else {
+        spi_active = 0;
+    }
+
+    xfer->done = 1;
+    if (xfer->callback) xfer->callback(xfer);
+}
+
+// shifts len bytes polling the SPI, before the DMA is set up
+void spi_transfer_polled(int dev, const unsigned char* tx, unsigned char* rx, int len){
+    spi_configure(dev);
+    spi_set_cs(dev, 0);
+    for (int i = 0; i < len; i++) {
+        while (SPI1STATbits.SPITBF == 1) hal_poll();
+        hal_spi_put(tx[i]);
+        while (SPI1STATbits.SPIRBF == 0) hal_poll();
+        rx[i] = hal_spi_get();
+    }
+    spi_set_cs(dev, 1);
+
+    //clear overflow
+    if (SPI1STATbits.SPIROV == 1){
+        SPI1STATbits.SPIROV = 0;
+    }
+}
+
+// blocking transfer of up to SPI_SYNC_MAX bytes: it waits for its turn in the
+// queue, so it never collides with the asynchronous transfers.
+// Must not be called from an interrupt
+void spi_transfer(int dev, const unsigned char* tx, unsigned char* rx, int len){
+    SpiTransfer xfer;
+
+    if (!spi_dma_ready) {
+        spi_transfer_polled(dev, tx, rx, len);
+        return;
+    }
+
+    xfer.dev = dev;
+    xfer.tx = tx;
+    xfer.rx = rx;
+    xfer.len = len;
+    xfer.callback = 0;
+    xfer.priority = SPI_PRIO_SYNC;
+    while (!spi_submit(&xfer)) hal_poll(); // queue full: wait for a slot
+    while (!xfer.done) hal_poll();
+}
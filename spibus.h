@@ -0,0 +1,98 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef SPIBUS_H
+#define	SPIBUS_H
+
+#include "hal.h" // processor registers and the side-effect accesses
+
+#define ACC_CS LATBbits.LATB3
+#define MAG_CS LATDbits.LATD6
+#define GYR_CS LATBbits.LATB4
+
+// devices on SPI1, index of the descriptor table in spibus.c
+#define SPI_DEV_ACC 0
+#define SPI_DEV_MAG 1
+#define SPI_DEV_GYR 2
+#define SPI_NUM_DEVS 3
+
+// SPI1CON1 of a device: master, 8-bit, clock polarity and edge,
+// Fcy / (primary * secondary) with PPRE 0b11=1:1 ... 0b00=64:1 and SPRE 0b111=1:1 ... 0b000=8:1
+#define SPI_CON1(ckp, cke, ppre, spre) (0x0020 | ((cke) << 8) | ((ckp) << 6) | ((spre) << 2) | (ppre))
+
+// transfer priorities, lower first; equal priorities are served in order
+#define SPI_PRIO_SYNC 0 // blocking transfers, the caller is waiting
+#define SPI_PRIO_MAG 1  // magnetometer, timestamped on DRDY
+#define SPI_PRIO_GYR 2
+#define SPI_PRIO_ACC 3
+#define SPI_PRIO_LOW 4
+
+#define SPI_QUEUE_SIZE 8 // maximum number of queued asynchronous transfers
+#define SPI_IPL 4        // priority of INT1 and DMA1, the interrupts that use the bus (default level)
+#define SPI_SYNC_MAX 32  // maximum length of a blocking transfer
+
+// chip-select and bus settings of a device
+typedef struct {
+    volatile unsigned int* cs_lat;
+    unsigned int cs_mask;
+    unsigned int con1; // see SPI_CON1()
+} SpiDevice;
+
+// asynchronous transfer descriptor: tx[0..len-1] is shifted out while
+// rx[0..len-1] is filled by DMA; done is set (and callback, if any, is called
+// from the DMA interrupt) once the chip-select has been released.
+// tx and rx must be in data RAM: the DMA cannot read const data kept in program memory
+typedef struct SpiTransfer {
+    int dev;
+    const unsigned char* tx;
+    unsigned char* rx;
+    int len;
+    volatile int done;
+    void (*callback)(struct SpiTransfer* xfer);
+    int priority; // SPI_PRIO_*
+} SpiTransfer;
+
+void spi_init();
+void spi_dma_init();
+void spi_set_cs(int dev, int level);
+int spi_submit(SpiTransfer* xfer);
+void spi_transfer(int dev, const unsigned char* tx, unsigned char* rx, int len);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* SPIBUS_H */
+
@@ -0,0 +1,76 @@
+/*
+ * File:   telem.c
+ * Author: group 6
+ *
+ * Compact binary telemetry: fixed-layout records with CRC-16, COBS framed.
+ * The decoder for the host is tools/telemetry_decode.py.
+ */
+
+#include "telem.h"
+
+unsigned char telem_seq = 0;
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+unsigned int telem_crc16(const unsigned char* data, unsigned int len){
+    unsigned int crc = 0xFFFF;
+
+    for (unsigned int i = 0; i < len; i++) {
+        crc ^= (unsigned int) data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+            else crc <<= 1;
+        }
+    }
+    return crc & 0xFFFF;
+}
+
+// Consistent Overhead Byte Stuffing: removes the 0x00 bytes so that 0x00 can
+// delimit the records. out must hold len + len / 254 + 1 bytes. Returns the encoded length
+unsigned int telem_cobs_encode(const unsigned char* in, unsigned int len, unsigned char* out){
+    unsigned int code_pos = 0; // where the length of the current block goes
+    unsigned int pos = 1;
+    unsigned char code = 1;
+
+    for (unsigned int i = 0; i < len; i++) {
+        if (in[i] != 0) {
+            out[pos++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return pos;
+}
+
+// formats a record directly in the TX buffer.
+// Returns 0 (and sends nothing) if the buffer has no room
+int telem_send(CircularBuffer* cb, unsigned char type, unsigned long stamp, const int* values, int n){
+    unsigned char raw[TELEM_RAW_LEN(TELEM_MAX_VALUES)];
+    unsigned char wire[TELEM_WIRE_LEN(TELEM_MAX_VALUES)];
+    unsigned int len = 0, crc, wire_len;
+    CbWriter w;
+
+    if (n > TELEM_MAX_VALUES) n = TELEM_MAX_VALUES;
+    if (!cb_reserve(cb, TELEM_WIRE_LEN(n), &w)) return 0;
+
+    raw[len++] = type;
+    raw[len++] = telem_seq++;
+    for (int b = 0; b < 32; b += 8) raw[len++] = (unsigned char) (stamp >> b);
+    for (int i = 0; i < n; i++) {
+        raw[len++] = (unsigned char) values[i];
+        raw[len++] = (unsigned char) ((unsigned int) values[i] >> 8);
+    }
+    crc = telem_crc16(raw, len);
+    raw[len++] = (unsigned char) crc;
+    raw[len++] = (unsigned char) (crc >> 8);
+
+    wire_len = telem_cobs_encode(raw, len, wire);
+    for (unsigned int i = 0; i < wire_len; i++) cbw_putc(&w, wire[i]);
+    cbw_putc(&w, 0);
+    cb_commit(&w);
+    return 1;
+}
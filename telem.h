@@ -0,0 +1,66 @@
+/* Microchip Technology Inc. and its subsidiaries.  You may use this software 
+ * and any derivatives exclusively with Microchip products. 
+ * 
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS".  NO WARRANTIES, WHETHER 
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED 
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A 
+ * PARTICULAR PURPOSE, OR ITS INTERACTION WITH MICROCHIP PRODUCTS, COMBINATION 
+ * WITH ANY OTHER PRODUCTS, OR USE IN ANY APPLICATION. 
+ *
+ * IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+ * INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+ * WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS 
+ * BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE 
+ * FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS 
+ * IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF 
+ * ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * MICROCHIP PROVIDES THIS SOFTWARE CONDITIONALLY UPON YOUR ACCEPTANCE OF THESE 
+ * TERMS. 
+ */
+
+/* 
+ * File:   
+ * Author: 
+ * Comments:
+ * Revision history: 
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef TELEM_H
+#define	TELEM_H
+
+#include "uart.h"
+
+// binary telemetry records, sent instead of the ASCII frames after $MODE,BIN*.
+// Layout (little-endian): type, sequence number, timestamp [us] (32 bits),
+// values (16-bit signed each), CRC-16/CCITT of the previous bytes.
+// The record is COBS-encoded and terminated by a 0x00 byte.
+#define TELEM_MAG 0x01 // x, y, z in 1/16 uT
+#define TELEM_YAW 0x02 // yaw in 0.1 degree
+// capture of the magnetometer samples after $CAP,ON*, replayed by sim/replay.c
+#define TELEM_RAW 0x03  // x, y, z, rhall as read from the sensor
+#define TELEM_TRIM 0x04 // x1, y1, x2, y2, z1, z2, z3, z4, xy1, xy2, xyz1 (see MagTrim)
+#define TELEM_CAL 0x05  // offset x, y, z, scale x, y, z (see MagCal)
+
+#define TELEM_MAX_VALUES 11
+#define TELEM_RAW_LEN(n) (8 + 2 * (n))
+// bytes on the wire: one COBS overhead byte for records shorter than 254, plus the delimiter
+#define TELEM_WIRE_LEN(n) (TELEM_RAW_LEN(n) + 2)
+
+unsigned int telem_crc16(const unsigned char* data, unsigned int len);
+unsigned int telem_cobs_encode(const unsigned char* in, unsigned int len, unsigned char* out);
+int telem_send(CircularBuffer* cb, unsigned char type, unsigned long stamp, const int* values, int n);
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* TELEM_H */
+
@@ -7,164 +7,202 @@
 
 #include "timer.h"
 
-void tmr_setup_period(int timer, int ms){
-    //the first function setups the timer timer to count for the specified number of milliseconds. 
-    //The function should support values up to 200 millisecond. 
-    //It should start the timer
-    if(ms > 200) return;
-    
-    long int Fcy = 72000000;
-    // Formula: PRx = (Fcy / Prescaler) * (ms / 1000)
-    //PR1 = 56250;
-    
-    if(timer == 1){
-        PR1 = (int) ((Fcy / 256) * (ms / 1000.0));
-    
-        T1CONbits.TCS = 0;
-        TMR1 = 0; // reset timer counter
-        T1CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T1IF = 0;
-        T1CONbits.TON = 1; // starts the timer!
-    }
-    
-    else if(timer == 2){
-        PR2 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T2CONbits.TCS = 0;
-        TMR2 = 0; // reset timer counter
-        T2CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T2IF = 0;
-        T2CONbits.TON = 1; // starts the timer!
-    }
-    else if(timer == 3){
-        PR3 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T3CONbits.TCS = 0;
-        TMR3 = 0; // reset timer counter
-        T3CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T3IF = 0;
-        T3CONbits.TON = 1; // starts the timer!
-    }
-    else if(timer == 4){
-        PR4 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T4CONbits.TCS = 0;
-        TMR4 = 0; // reset timer counter
-        T4CONbits.TCKPS = 3; // prescaler 1:256
-        IFS1bits.T4IF = 0;
-        T4CONbits.TON = 1; // starts the timer!
-    }
-    
-}
+// registers of a timer
+typedef struct {
+    volatile unsigned int* con;
+    volatile unsigned int* tmr;
+    volatile unsigned int* pr;
+    int slave;                  // timer holding the upper word in 32-bit mode, 0 if none
+} TimerRegs;
 
-int tmr_wait_period(int timer){
-    if (timer == 1){
-        if(IFS0bits.T1IF == 0){
-            while (IFS0bits.T1IF == 0);
-            IFS0bits.T1IF = 0;
-            return 0; 
-        }
-        else if(IFS0bits.T1IF == 1){
+const TimerRegs tmr_regs[6] = {
+    {0, 0, 0, 0},
+    {&T1CON, &TMR1, &PR1, 0},       // TIMER1
+    {&T2CON, &TMR2, &PR2, TIMER3},  // TIMER2
+    {&T3CON, &TMR3, &PR3, 0},       // TIMER3
+    {&T4CON, &TMR4, &PR4, TIMER5},  // TIMER4
+    {&T5CON, &TMR5, &PR5, 0},       // TIMER5
+};
+
+#define TCON_TON 0x8000
+#define TCON_T32 0x0008
+#define TCON_TCKPS_SHIFT 4
+
+volatile int tmr_expired[6];            // set by the interrupt at the end of each period
+int tmr_owner[6] = {0, 1, 2, 3, 4, 5};  // timer whose period each interrupt signals
+volatile unsigned long tmr_idle_counts; // clock counts spent in Idle
+unsigned long tmr_load_start;           // clock at the beginning of the load window
+unsigned long tmr_load_idle;            // tmr_idle_counts at the beginning of the load window
+
+// clears the interrupt flag of the timer and enables or disables its interrupt.
+// Single-bit writes: a read-modify-write of IFSx/IECx would lose (or restore)
+// the flags of the other interrupts changed meanwhile by the hardware or an ISR
+void tmr_irq(int timer, int enable){
+    switch (timer) {
+        case TIMER1:
             IFS0bits.T1IF = 0;
-            return 1;
-        }
-    }
-    else if(timer == 2){
-        if(IFS0bits.T2IF == 0){
-            while (IFS0bits.T2IF == 0);
-            IFS0bits.T2IF = 0;
-            return 0;
-        }
-        else if(IFS0bits.T2IF == 1){
-            IFS0bits.T2IF = 0;
-            return 1;
-        }
-    }
-    else if(timer == 3){
-        if(IFS0bits.T3IF == 0){
-            while (IFS0bits.T3IF == 0);
+            IEC0bits.T1IE = enable;
+            break;
+        case TIMER2:
             IFS0bits.T2IF = 0;
-            return 0;
-        }
-        else if(IFS0bits.T3IF == 1){
+            IEC0bits.T2IE = enable;
+            break;
+        case TIMER3:
             IFS0bits.T3IF = 0;
-            return 1;
-        }
-    }
-    else if(timer == 4){
-        if(IFS1bits.T4IF == 0){
-            while (IFS1bits.T4IF == 0);
-            IFS1bits.T4IF = 0;
-            return 0;
-        }
-        else if(IFS1bits.T4IF == 1){
+            IEC0bits.T3IE = enable;
+            break;
+        case TIMER4:
             IFS1bits.T4IF = 0;
-            return 1;
-        }
+            IEC1bits.T4IE = enable;
+            break;
+        case TIMER5:
+            IFS1bits.T5IF = 0;
+            IEC1bits.T5IE = enable;
+            break;
     }
 }
-void tmr_wait_ms(int timer, int ms){
-    long int Fcy = 72000000;
-    // Formula: PRx = (Fcy / Prescaler) * (ms / 1000)
-    //PR1 = 56250;
-    if(ms > 200) return;
-    
-    if(timer == 1){
-        PR1 = (int) ((Fcy / 256) * (ms / 1000.0));
-    
-        T1CONbits.TCS = 0;
-        TMR1 = 0; // reset timer counter
-        T1CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T1IF = 0;
-        T1CONbits.TON = 1; // starts the timer!
-    }
-    
-    else if(timer == 2){
-        PR2 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T2CONbits.TCS = 0;
-        TMR2 = 0; // reset timer counter
-        T2CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T2IF = 0;
-        T2CONbits.TON = 1; // starts the timer!
-    }
-    else if(timer == 3){
-        PR3 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T3CONbits.TCS = 0;
-        TMR3 = 0; // reset timer counter
-        T3CONbits.TCKPS = 3; // prescaler 1:256
-        IFS0bits.T3IF = 0;
-        T3CONbits.TON = 1; // starts the timer!
-    }
-    else if(timer == 4){
-        PR4 = (int) ((Fcy / 256) * (ms / 1000.0));
-
-        T4CONbits.TCS = 0;
-        TMR4 = 0; // reset timer counter
-        T4CONbits.TCKPS = 3; // prescaler 1:256
-        IFS1bits.T4IF = 0;
-        T4CONbits.TON = 1; // starts the timer!
-    }
-    
-    if(timer == 1){
-        while (IFS0bits.T1IF == 0);
 
-        IFS0bits.T1IF = 0;      
-    }
-    else if(timer == 2){
-        while (IFS0bits.T2IF == 0);
+// sets up the timer with the given prescaler (TCKPS: 0=1:1, 1=1:8, 2=1:64, 3=1:256)
+// and period (counts - 1) and starts it, see tmr_setup_period().
+// Periods longer than 16 bits use the 32-bit pair TIMER2/3 or TIMER4/5.
+// Returns 0 if the period cannot be handled by the timer.
+int tmr_setup(int timer, unsigned int tckps, unsigned long period){
+    const TimerRegs* t = &tmr_regs[timer];
+    int irq = timer; // timer that raises the interrupt
+    unsigned int con = tckps << TCON_TCKPS_SHIFT;
 
-        IFS0bits.T2IF = 0;      
-    }
-    else if(timer == 3){
-        while (IFS0bits.T3IF == 0);
+    if (period > 0xFFFFUL) {
+        if (t->slave == 0) return 0;
 
-        IFS0bits.T3IF = 0;      
+        irq = t->slave;
+        *tmr_regs[irq].con = 0;
+        *tmr_regs[irq].tmr = 0; // upper word of the pair counter
+        *tmr_regs[irq].pr = period >> 16;
+        tmr_owner[t->slave] = timer;
+        con |= TCON_T32;
+    } else if (t->slave != 0) {
+        tmr_owner[t->slave] = t->slave;
     }
-    else if(timer == 4){
-        while (IFS1bits.T4IF == 0);
 
-        IFS1bits.T4IF = 0;      
+    *t->con = 0;
+    *t->tmr = 0; // reset timer counter
+    *t->pr = period;
+    tmr_expired[timer] = 0;
+    tmr_irq(irq, 1); // the interrupt wakes the CPU from Idle
+    *t->con = con | TCON_TON; // starts the timer!
+    return 1;
+}
+
+// puts the CPU in Idle until the period of the timer expires.
+// The CPU priority is raised to 7 while testing the flag and entering Idle,
+// so an interrupt cannot slip in between: it still wakes the CPU, which then
+// lowers the priority to let the pending interrupts be serviced.
+void tmr_idle_until(int timer){
+    int ipl;
+    unsigned long start;
+
+    SET_AND_SAVE_CPU_IPL(ipl, 7);
+    while (!tmr_expired[timer]) {
+        start = tmr_clock();
+        Idle();
+        tmr_idle_counts += TMR_CLOCK_DIFF(tmr_clock(), start);
+
+        RESTORE_CPU_IPL(ipl); // pending interrupts are serviced here
+        SET_AND_SAVE_CPU_IPL(ipl, 7);
     }
-}
\ No newline at end of file
+    RESTORE_CPU_IPL(ipl);
+}
+
+// waits in Idle for the end of the period.
+// Returns 1 if the period had already expired (deadline missed), 0 otherwise
+int tmr_wait_period(int timer){
+    int missed = tmr_expired[timer];
+
+    if (!missed) tmr_idle_until(timer);
+    tmr_expired[timer] = 0;
+    return missed;
+}
+
+// one-shot wait, see tmr_wait_ms()
+void tmr_wait(int timer, unsigned int tckps, unsigned long period){
+    const TimerRegs* t = &tmr_regs[timer];
+    int irq = (period > 0xFFFFUL) ? t->slave : timer;
+
+    if (!tmr_setup(timer, tckps, period)) return;
+    tmr_idle_until(timer);
+
+    // stop the timer so that it does not wake the CPU any more
+    *t->con = 0;
+    tmr_irq(irq, 0);
+    tmr_expired[timer] = 0;
+}
+
+// starts TIMER4/TIMER5 as a free-running 32-bit clock at Fcy/8 (wraps after about 8 minutes).
+// While the clock runs TIMER4 and TIMER5 cannot be used with the other functions.
+void tmr_start_clock(){
+    T4CON = 0;
+    T5CON = 0;
+    TMR5HLD = 0;
+    TMR4 = 0; // reset timer counter
+    PR5 = 0xFFFF;
+    PR4 = 0xFFFF;
+    IFS1bits.T5IF = 0;
+    T4CON = TCON_TON | TCON_T32 | (1 << TCON_TCKPS_SHIFT); // 32-bit, prescaler 1:8
+}
+
+// reads the free-running clock: reading TMR4 latches the upper word in TMR5HLD.
+// Also called by interrupts (INT1): the two reads must not be split by another
+// read of TMR4, which would reload TMR5HLD
+unsigned long tmr_clock(){
+    unsigned int lsw, msw;
+    int ipl;
+
+    SET_AND_SAVE_CPU_IPL(ipl, 7);
+    lsw = TMR4;
+    msw = TMR5HLD;
+    RESTORE_CPU_IPL(ipl);
+    return ((unsigned long) msw << 16) | lsw;
+}
+
+// CPU load since the previous call, in tenths of percent (0-1000).
+// busy and idle return the time spent running and sleeping, in clock counts
+unsigned int tmr_cpu_load(unsigned long* busy, unsigned long* idle){
+    unsigned long now = tmr_clock();
+    unsigned long total = TMR_CLOCK_DIFF(now, tmr_load_start);
+    unsigned long slept = tmr_idle_counts - tmr_load_idle;
+
+    tmr_load_start = now;
+    tmr_load_idle += slept;
+
+    if (slept > total) slept = total;
+    *busy = total - slept;
+    *idle = slept;
+    if (total == 0) return 0;
+    return (unsigned int) (((unsigned long long) *busy * 1000) / total);
+}
+
+// Interrupts of the timers: they only record the end of the period
+void __attribute__((__interrupt__, __auto_psv__)) _T1Interrupt() {
+    IFS0bits.T1IF = 0;
+    tmr_expired[tmr_owner[TIMER1]] = 1;
+}
+
+void __attribute__((__interrupt__, __auto_psv__)) _T2Interrupt() {
+    IFS0bits.T2IF = 0;
+    tmr_expired[tmr_owner[TIMER2]] = 1;
+}
+
+void __attribute__((__interrupt__, __auto_psv__)) _T3Interrupt() {
+    IFS0bits.T3IF = 0;
+    tmr_expired[tmr_owner[TIMER3]] = 1;
+}
+
+void __attribute__((__interrupt__, __auto_psv__)) _T4Interrupt() {
+    IFS1bits.T4IF = 0;
+    tmr_expired[tmr_owner[TIMER4]] = 1;
+}
+
+void __attribute__((__interrupt__, __auto_psv__)) _T5Interrupt() {
+    IFS1bits.T5IF = 0;
+    tmr_expired[tmr_owner[TIMER5]] = 1;
+}
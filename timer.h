@@ -31,17 +31,44 @@
 #ifndef TIMER_H
 #define	TIMER_H
 
-#include <xc.h> // include processor files - each processor file is guarded.  
+#include "hal.h" // processor registers and the side-effect accesses
 
 // TODO Insert appropriate #include <>
 #define TIMER1 1
-#define TIMER2 2
+#define TIMER2 2 // with TIMER3 forms a 32-bit timer for long periods
 #define TIMER3 3
-#define TIMER4 4
+#define TIMER4 4 // with TIMER5 forms a 32-bit timer for long periods
+#define TIMER5 5
 
-void tmr_setup_period(int timer, int ms);
-void tmr_wait_ms(int timer, int ms);
+#define TMR_FCY 72000000UL
+
+#define TMR_CLOCK_PER_US 9 // counts of the free-running clock per microsecond (Fcy/8)
+// counts between two readings of tmr_clock(), across the wrap of the 32-bit clock
+// (unsigned long is wider than 32 bits in the host build)
+#define TMR_CLOCK_DIFF(end, start) (((end) - (start)) & 0xFFFFFFFFUL)
+
+// Prescaler and period for ms milliseconds. The smallest prescaler (1, 8, 64, 256)
+// whose period fits in 16 bits is chosen; above 233ms the period needs a 32-bit timer.
+// When ms is a constant everything is computed by the compiler.
+#define TMR_COUNTS(ms, div) (((TMR_FCY / 1000) * (unsigned long) (ms)) / (div))
+#define TMR_TCKPS(ms) (TMR_COUNTS(ms, 1) <= 0x10000UL ? 0 : \
+                       TMR_COUNTS(ms, 8) <= 0x10000UL ? 1 : \
+                       TMR_COUNTS(ms, 64) <= 0x10000UL ? 2 : 3)
+#define TMR_DIV(tckps) ((tckps) == 0 ? 1 : (tckps) == 1 ? 8 : (tckps) == 2 ? 64 : 256)
+#define TMR_PERIOD(ms) (TMR_COUNTS(ms, TMR_DIV(TMR_TCKPS(ms))) - 1)
+
+// the timer counts for the specified number of milliseconds, it is started
+#define tmr_setup_period(timer, ms) tmr_setup((timer), TMR_TCKPS(ms), TMR_PERIOD(ms))
+// waits (in Idle) for the specified number of milliseconds
+#define tmr_wait_ms(timer, ms) tmr_wait((timer), TMR_TCKPS(ms), TMR_PERIOD(ms))
+
+int tmr_setup(int timer, unsigned int tckps, unsigned long period);
+void tmr_wait(int timer, unsigned int tckps, unsigned long period);
 int tmr_wait_period(int timer);
+void tmr_idle_until(int timer);
+unsigned int tmr_cpu_load(unsigned long* busy, unsigned long* idle);
+void tmr_start_clock();
+unsigned long tmr_clock();
 
 
 #ifdef	__cplusplus
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Decoder of the binary telemetry sent after $MODE,BIN* (see telem.h).
+
+Records are COBS-encoded and delimited by 0x00:
+    type (u8), seq (u8), timestamp in us (u32), values (i16 each), CRC-16/CCITT (u16)
+all little-endian. ASCII frames ($ERR, $STAT, ...) are also followed by 0x00
+in binary mode and are printed as they are.
+
+Usage:
+    telemetry_decode.py FILE            decode a capture ('-' for stdin)
+    telemetry_decode.py --port /dev/ttyUSB0 [--baud 9600]   (needs pyserial)
+    telemetry_decode.py --port /dev/ttyUSB0 --raw capture.bin
+                                        also save the stream, e.g. after $CAP,ON*
+                                        for sim/replay.c
+
+Output is one CSV line per record: type,seq,timestamp_us,values...
+MAG values are converted to uT, YAW to degrees; RAW, TRIM and CAL
+(sample capture) are printed as they are.
+"""
+
+import argparse
+import struct
+import sys
+
+TELEM_MAG = 0x01
+TELEM_YAW = 0x02
+TELEM_RAW = 0x03
+TELEM_TRIM = 0x04
+TELEM_CAL = 0x05
+
+TYPES = {
+    TELEM_MAG: ("MAG", lambda v: ["%.4f" % (x / 16.0) for x in v]),
+    TELEM_YAW: ("YAW", lambda v: ["%.1f" % (x / 10.0) for x in v]),
+    TELEM_RAW: ("RAW", lambda v: [str(x) for x in v]),
+    TELEM_TRIM: ("TRIM", lambda v: [str(x) for x in v]),
+    TELEM_CAL: ("CAL", lambda v: [str(x) for x in v[:3]] + [str(x & 0xFFFF) for x in v[3:]]),
+}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as telem_crc16()."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Returns the decoded bytes, None if the encoding is not valid."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        block = data[i + 1:i + code]
+        if code == 0 or len(block) != code - 1:
+            return None
+        out += block
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_record(raw):
+    """Returns (type, seq, stamp, values) or None if the record is corrupted."""
+    if len(raw) < 8 or (len(raw) - 8) % 2:
+        return None
+    body, crc = raw[:-2], struct.unpack("<H", raw[-2:])[0]
+    if crc16(body) != crc:
+        return None
+    rtype, seq, stamp = struct.unpack("<BBI", body[:6])
+    n = (len(body) - 6) // 2
+    values = struct.unpack("<%dh" % n, body[6:])
+    return rtype, seq, stamp, values
+
+
+class Decoder:
+    def __init__(self, out):
+        self.out = out
+        self.buf = bytearray()
+        self.last_seq = None
+        self.errors = 0
+        self.lost = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            end = self.buf.find(0)
+            if end < 0:
+                return
+            chunk = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if chunk:
+                self.frame(chunk)
+
+    def frame(self, chunk):
+        if chunk.startswith(b"$") or chunk.startswith(b" $"):
+            # the ASCII frames sent before $CAP,ON* have no delimiter and
+            # precede the first record
+            record = b""
+            for i in range(len(chunk) - 1):
+                raw = cobs_decode(chunk[i + 1:]) if chunk[i] == ord("*") else None
+                if raw is not None and decode_record(raw) is not None:
+                    chunk, record = chunk[:i + 1], chunk[i + 1:]
+                    break
+            self.out.write(chunk.decode("ascii", "replace").strip() + "\n")
+            if not record:
+                return
+            chunk = record
+        raw = cobs_decode(chunk)
+        rec = decode_record(raw) if raw is not None else None
+        if rec is None:
+            self.errors += 1
+            return
+        rtype, seq, stamp, values = rec
+        # one sequence number for all the record types
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+        name, conv = TYPES.get(rtype, ("T%02X" % rtype, lambda v: [str(x) for x in v]))
+        self.out.write(",".join([name, str(seq), str(stamp)] + conv(values)) + "\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("file", nargs="?", help="capture file, '-' for stdin")
+    ap.add_argument("--port", help="serial port")
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("--raw", help="also save the bytes received to this file")
+    args = ap.parse_args()
+
+    dec = Decoder(sys.stdout)
+    raw = open(args.raw, "wb") if args.raw else None
+    try:
+        if args.port:
+            import serial
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                while True:
+                    data = port.read(256)
+                    if raw:
+                        raw.write(data)
+                    dec.feed(data)
+        else:
+            if not args.file:
+                ap.error("a capture file or --port is needed")
+            src = sys.stdin.buffer if args.file == "-" else open(args.file, "rb")
+            with src:
+                data = src.read()
+                if raw:
+                    raw.write(data)
+                dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    if raw:
+        raw.close()
+    sys.stderr.write("corrupted records: %d, lost records: %d\n" % (dec.errors, dec.lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -8,6 +8,11 @@
 
 #include "uart.h"
 
+// rates accepted by uart_set_baud(). At 921600 the error of the
+// divider is 2.3% (900000 baud), the others are within 0.2%
+const unsigned long uart_rates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+unsigned long uart_current_baud = BAUDRATE;
+
 // Inizializzazione UART1
 void UART1_Init(void) {
     TRISDbits.TRISD11 = 1; // set RD11 as input (U1RX)
@@ -16,7 +21,9 @@ void UART1_Init(void) {
     RPINR18bits.U1RXR = 75; // RD11 mapped on U1RX
     RPOR0bits.RP64R = 1;    // RD0 mapped on U1TX
     
+    U1MODEbits.BRGH = 1; // high-speed mode, 4 clocks per bit
     U1BRG = BRGVAL; // baudrate setting
+    uart_current_baud = BAUDRATE;
     
     U1STAbits.UTXISEL0 = 0; // Interrupt after one TX Character is transmitted
     U1STAbits.UTXISEL1 = 0;
@@ -26,30 +33,138 @@ void UART1_Init(void) {
     IEC0bits.U1RXIE = 1;   // enable RX interrupt
 }
 
+// Returns 1 if the rate is in uart_rates
+int uart_baud_supported(unsigned long baud){
+    for (unsigned int i = 0; i < sizeof(uart_rates) / sizeof(uart_rates[0]); i++) {
+        if (uart_rates[i] == baud) return 1;
+    }
+    return 0;
+}
+
+// changes the baud rate, the characters still being shifted are lost.
+// Returns 0 if the rate is not supported
+int uart_set_baud(unsigned long baud){
+    if (!uart_baud_supported(baud)) return 0;
+
+    U1MODEbits.UARTEN = 0;
+    U1BRG = UART_BRG(baud);
+    U1MODEbits.UARTEN = 1;
+    U1STAbits.UTXEN = 1; // cleared when the UART is disabled
+    U1STAbits.OERR = 0;  // characters received at the wrong rate
+    uart_current_baud = baud;
+    return 1;
+}
+
+unsigned long uart_baud(){
+    return uart_current_baud;
+}
+
+// Returns 1 once the last character has left the shift register
+int uart_tx_idle(){
+    return U1STAbits.TRMT;
+}
+
 //circular buffer
 void cb_init(CircularBuffer *cb) {
     cb->head = 0;
     cb->tail = 0;
-    cb->count = 0;
 }
 
-void cb_push(CircularBuffer *cb, char value) {
-    if (cb->count == BUFFER_SIZE){
-         // Buffer full: overwrite oldest
-        cb->tail = (cb->tail + 1) % BUFFER_SIZE;
-        cb->count--;
-    }
-    cb->buffer[cb->head] = value; // write the value
-    cb->head = (cb->head + 1) % BUFFER_SIZE; // increment circularly
-    cb->count++;
+// number of characters in the buffer
+unsigned int cb_count(CircularBuffer *cb) {
+    return cb->head - cb->tail;
+}
+
+// number of characters that can still be pushed
+unsigned int cb_free(CircularBuffer *cb) {
+    return BUFFER_SIZE - (cb->head - cb->tail);
+}
+
+// producer side: returns 0 (and drops the value) if the buffer is full
+int cb_push(CircularBuffer *cb, char value) {
+    unsigned int head = cb->head;
+
+    if (head - cb->tail == BUFFER_SIZE) return 0;
+
+    cb->buffer[head & BUFFER_MASK] = value; // write the value
+    cb->head = head + 1; // then publish it
+    return 1;
 }
 
-void cb_pop(CircularBuffer *cb, char *value) {
-    *value = cb->buffer[cb->tail]; // read the value
-    cb->tail = (cb->tail + 1) % BUFFER_SIZE; // increment circularly
-    cb->count--;
+// consumer side: returns 0 if the buffer is empty
+int cb_pop(CircularBuffer *cb, char *value) {
+    unsigned int tail = cb->tail;
+
+    if (cb->head == tail) return 0;
+
+    *value = cb->buffer[tail & BUFFER_MASK]; // read the value
+    cb->tail = tail + 1; // then release the slot
+    return 1;
 }
 
 int cb_is_empty(CircularBuffer *cb) {
-    return cb->count == 0;
+    return cb->head == cb->tail;
+}
+
+// producer side: pushes the whole frame or nothing.
+// Returns the number of characters pushed (n or 0)
+unsigned int cb_push_n(CircularBuffer *cb, const char *data, unsigned int n) {
+    unsigned int head = cb->head;
+
+    if (BUFFER_SIZE - (head - cb->tail) < n) return 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        cb->buffer[(head + i) & BUFFER_MASK] = data[i];
+    }
+    cb->head = head + n;
+    return n;
+}
+
+// consumer side: copies up to n characters without removing them.
+// Returns the number of characters copied
+unsigned int cb_peek(CircularBuffer *cb, char *data, unsigned int n) {
+    unsigned int tail = cb->tail;
+    unsigned int count = cb->head - tail;
+
+    if (n > count) n = count;
+
+    for (unsigned int i = 0; i < n; i++) {
+        data[i] = cb->buffer[(tail + i) & BUFFER_MASK];
+    }
+    return n;
+}
+
+// consumer side: removes up to n characters.
+// Returns the number of characters removed
+unsigned int cb_pop_n(CircularBuffer *cb, char *data, unsigned int n) {
+    n = cb_peek(cb, data, n);
+    cb->tail = cb->tail + n;
+    return n;
 }
+
+// producer side: reserves n characters for a frame that is written in place.
+// Returns 0 if there is not enough room (the frame should be skipped)
+int cb_reserve(CircularBuffer *cb, unsigned int n, CbWriter *w) {
+    if (cb_free(cb) < n) return 0;
+
+    w->cb = cb;
+    w->pos = cb->head;
+    w->end = cb->head + n;
+    return 1;
+}
+
+// publishes the characters written so far, the unused reserved space is released
+void cb_commit(CbWriter *w) {
+    w->cb->head = w->pos;
+}
+
+void cbw_putc(CbWriter *w, char c) {
+    if (w->pos == w->end) return; // never write past the reservation
+    w->cb->buffer[w->pos & BUFFER_MASK] = c;
+    w->pos++;
+}
+
+void cbw_puts(CbWriter *w, const char *s) {
+    while (*s) cbw_putc(w, *s++);
+}
+
@@ -31,27 +31,62 @@
 #ifndef UART_H
 #define	UART_H
 
-#include <xc.h> // include processor files - each processor file is guarded.  
+#include "hal.h" // processor registers and the side-effect accesses
 
-#define BAUDRATE 9600UL
+#define BAUDRATE 9600UL   // at reset, changed with $BAUD
+#define BAUD_MAX 921600UL // highest rate accepted by uart_set_baud()
 #define FCY 72000000UL  
-#define BRGVAL ((FCY / (16 * BAUDRATE)) - 1)
-#define BUFFER_SIZE 32 // calculated based on the baudrate and the time it takes to send a character
+// high-speed mode (BRGH = 1): baud = FCY / (4 * (BRG + 1)), rounded to the nearest BRG
+#define UART_BRG(baud) ((FCY + 2 * (baud)) / (4 * (baud)) - 1)
+#define BRGVAL UART_BRG(BAUDRATE)
 
-// circular buffer
+// the buffers are emptied once per tick: they must hold what can arrive in a tick
+// at the highest rate (10 bits per character), and at least 128 characters
+// (a $MAG and a $YAW frame must fit together, a $STAT frame is up to 64)
+#define UART_TICK_HZ 100
+#define UART_TICK_CHARS(baud) ((baud) / 10 / UART_TICK_HZ + 1)
+#define UART_POW2(n) ((n) <= 128 ? 128 : (n) <= 256 ? 256 : (n) <= 512 ? 512 : (n) <= 1024 ? 1024 : 2048)
+#define BUFFER_SIZE UART_POW2(UART_TICK_CHARS(BAUD_MAX))
+#define BUFFER_MASK (BUFFER_SIZE - 1) // BUFFER_SIZE must be a power of two
+
+// single-producer/single-consumer circular buffer:
+// head is written only by the producer and tail only by the consumer,
+// so neither side has to disable interrupts to access it.
+// The indexes run freely and are masked on access.
 typedef struct {
-    char buffer[BUFFER_SIZE];
-    int head; // write index
-    int tail; // read index
-    int count; // number of elements in the buffer
+    volatile char buffer[BUFFER_SIZE];
+    volatile unsigned int head; // write index
+    volatile unsigned int tail; // read index
 } CircularBuffer;
 
+// space reserved in a circular buffer by the producer:
+// a frame is formatted in place and becomes visible to the consumer on cb_commit()
+typedef struct {
+    CircularBuffer *cb;
+    unsigned int pos; // next write index
+    unsigned int end; // end of the reserved space
+} CbWriter;
+
 void cb_init(CircularBuffer *cb);
-void cb_push(CircularBuffer *cb, char value);
-void cb_pop(CircularBuffer *cb, char *value);
+int cb_push(CircularBuffer *cb, char value);
+int cb_pop(CircularBuffer *cb, char *value);
 int cb_is_empty(CircularBuffer *cb);
+unsigned int cb_count(CircularBuffer *cb);
+unsigned int cb_free(CircularBuffer *cb);
+unsigned int cb_push_n(CircularBuffer *cb, const char *data, unsigned int n);
+unsigned int cb_pop_n(CircularBuffer *cb, char *data, unsigned int n);
+unsigned int cb_peek(CircularBuffer *cb, char *data, unsigned int n);
+
+int cb_reserve(CircularBuffer *cb, unsigned int n, CbWriter *w);
+void cb_commit(CbWriter *w);
+void cbw_putc(CbWriter *w, char c);
+void cbw_puts(CbWriter *w, const char *s);
 
 void UART1_Init();
+int uart_baud_supported(unsigned long baud);
+int uart_set_baud(unsigned long baud);
+unsigned long uart_baud();
+int uart_tx_idle();
 
 #ifdef	__cplusplus
 extern "C" {